@@ -0,0 +1,131 @@
+#ifndef __BATCH_BORUVKA_H
+#define __BATCH_BORUVKA_H
+
+#include <algorithm>
+#include <limits>
+#include <omp.h>
+#include <tuple>
+#include <vector>
+
+#include "defs.h"
+#include "graph.h"
+#include "parallel_array.h"
+#include "parallel_boruvka.h"
+#include "sequential_dsu.h"
+#include "timer.h"
+
+struct BatchMSTResult {
+    std::vector<ParallelArray<Edge>> msts;
+    double graphs_per_second;
+};
+
+/**
+ * Calculates MSTs of many graphs at once
+ *
+ * Graphs with less than SMALL_GRAPH_EDGES edges are spread between threads,
+ * each of them is solved by a single thread with no OpenMP regions inside.
+ * The rest are solved one by one with ParallelBoruvkaMST using all threads,
+ * this way parallel regions are never nested. Graphs are only read, none of them is copied
+ */
+struct BatchBoruvkaMST {
+    const u32 SMALL_GRAPH_EDGES = 1 << 16;
+    const u32 NO_EDGE = std::numeric_limits<u32>::max();
+
+    /**
+     * Calculates MST of a small graph on the calling thread, graph is not modified
+     * If the graph is not connected, mst is shrunk to its spanning forest
+     *
+     * Instead of contracting the graph, every round scans all of its edges and
+     * looks up their components in the DSU. That is O(E log V) in total, but
+     * there are no allocations per round and the graph fits in cache anyway
+     */
+    void calculate_small_mst(const Graph& graph, ParallelArray<Edge>& mst) {
+        u32 num_nodes = graph.num_nodes();
+        if (num_nodes == 0) return;
+
+        SequentialDSU node_sets(num_nodes);
+        std::vector<u32> shortest_edges(num_nodes);
+        u32 current_mst_size = 0;
+
+        while (current_mst_size + 1 < num_nodes) {
+            std::fill(shortest_edges.begin(), shortest_edges.end(), NO_EDGE);
+
+            for (u32 i = 0; i < graph.num_edges(); ++i) {
+                const Edge& e = graph.edges[i];
+                u32 u = node_sets.find_root(e.from);
+
+                if (u == node_sets.find_root(e.to)) continue;
+
+                if (shortest_edges[u] == NO_EDGE || canonical_key(e) < canonical_key(graph.edges[shortest_edges[u]])) {
+                    shortest_edges[u] = i;
+                }
+            }
+
+            u32 old_mst_size = current_mst_size;
+
+            for (u32 u = 0; u < num_nodes; ++u) {
+                if (shortest_edges[u] == NO_EDGE) continue;
+
+                const Edge& e = graph.edges[shortest_edges[u]];
+                if (!node_sets.same_set(e.from, e.to)) {
+                    node_sets.unite(e.from, e.to);
+                    mst[current_mst_size++] = e;
+                }
+            }
+
+            /* Graph is not connected */
+            if (current_mst_size == old_mst_size) break;
+        }
+
+        mst.shrink(current_mst_size);
+    }
+
+    /**
+     * Calculates MSTs of given graphs
+     * Result holds MSTs in the order of graphs and the overall throughput,
+     * graphs which are not connected get spanning forests on both paths
+     */
+    BatchMSTResult calculate_msts(const std::vector<Graph>& graphs, u32 NUM_THREADS = omp_get_max_threads()) {
+        u64 start = currentSeconds();
+
+        BatchMSTResult result;
+        result.msts.reserve(graphs.size());
+
+        std::vector<u32> small_graphs;
+        std::vector<u32> large_graphs;
+
+        for (u32 i = 0; i < graphs.size(); ++i) {
+            u32 num_nodes = graphs[i].num_nodes();
+            result.msts.emplace_back(num_nodes == 0 ? 0 : num_nodes - 1, NUM_THREADS);
+
+            if (graphs[i].num_edges() < SMALL_GRAPH_EDGES) {
+                small_graphs.push_back(i);
+            } else {
+                large_graphs.push_back(i);
+            }
+        }
+
+        /* Largest graphs first, so that threads finish at about the same time */
+        std::sort(small_graphs.begin(), small_graphs.end(), [&](u32 a, u32 b) {
+            return graphs[a].num_edges() > graphs[b].num_edges();
+        });
+
+        #pragma omp parallel for schedule(dynamic) num_threads(NUM_THREADS)
+        for (u32 i = 0; i < small_graphs.size(); ++i) {
+            u32 id = small_graphs[i];
+            calculate_small_mst(graphs[id], result.msts[id]);
+        }
+
+        ParallelBoruvkaMST boruvka;
+        for (u32 id : large_graphs) {
+            result.msts[id] = boruvka.calculate_mst(graphs[id], NUM_THREADS);
+        }
+
+        u64 finish = currentSeconds();
+        result.graphs_per_second = graphs.size() * 1e9 / std::max<u64>(finish - start, 1);
+
+        return result;
+    }
+};
+
+#endif
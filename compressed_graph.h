@@ -0,0 +1,170 @@
+#ifndef __COMPRESSED_GRAPH_H
+#define __COMPRESSED_GRAPH_H
+
+#include <algorithm>
+#include <omp.h>
+#include <parallel/numeric>
+
+#include "defs.h"
+#include "graph.h"
+#include "parallel_array.h"
+
+/**
+ * Compressed form of a graph with sorted edges, which is what BasicGraph stores after sort_edges()
+ * Nodes must be 0 .. N - 1
+ *
+ * offsets[u] .. offsets[u + 1] - 1 are the ids of edges from u (CSR), they replace repeated from values
+ * weights[id] - weight of edge id, stored as is
+ * targets - to of every edge as a varint (7 bits per byte, the high bit is set if more bytes follow)
+ *   the first edge of u stores zigzag(to - u), because in road networks neighbours have close ids,
+ *   the rest store the difference with the previous to, which is not negative since edges are sorted
+ * target_offsets[u] - where the targets of u start in targets
+ *
+ * Targets of different nodes can be decoded independently, so every pass over edges
+ * can still be split between threads by nodes
+ */
+template<typename W = u32, typename I = u32>
+struct BasicCompressedGraph {
+    ParallelArray<I> offsets;
+    ParallelArray<u64> target_offsets;
+    ParallelArray<u8, u64> targets;
+    ParallelArray<W, I> weights;
+
+    BasicCompressedGraph(const BasicGraph<W, I>& graph, u32 NUM_THREADS = omp_get_max_threads())
+        : offsets(graph.num_nodes() + 1, NUM_THREADS),
+          target_offsets(graph.num_nodes() + 1, NUM_THREADS),
+          targets(0, NUM_THREADS),
+          weights(graph.num_edges(), NUM_THREADS) {
+        u32 num_nodes = graph.num_nodes();
+        const BasicEdge<W>* edges = graph.edges.begin();
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 u = 0; u <= num_nodes; ++u) {
+            offsets[u] = std::lower_bound(edges, edges + graph.num_edges(), u,
+                                          [](const BasicEdge<W>& e, u32 node) { return e.from < node; }) - edges;
+        }
+
+        ParallelArray<u64> target_sizes(num_nodes + 1, NUM_THREADS);
+        target_sizes[0] = 0;
+
+        #pragma omp parallel for schedule(guided) num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            u64 size = 0;
+            u32 last = u;
+
+            for (I i = offsets[u]; i < offsets[u + 1]; ++i) {
+                size += varint_size(delta(u, i == offsets[u], last, edges[i].to));
+                last = edges[i].to;
+            }
+
+            target_sizes[u + 1] = size;
+        }
+
+        __gnu_parallel::partial_sum(target_sizes.begin(), target_sizes.end(), target_offsets.begin());
+
+        ParallelArray<u8, u64> new_targets(target_offsets[num_nodes], NUM_THREADS);
+        targets.swap(new_targets);
+
+        #pragma omp parallel for schedule(guided) num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            u8* out = targets.begin() + target_offsets[u];
+            u32 last = u;
+
+            for (I i = offsets[u]; i < offsets[u + 1]; ++i) {
+                out = write_varint(out, delta(u, i == offsets[u], last, edges[i].to));
+                last = edges[i].to;
+            }
+        }
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < graph.num_edges(); ++i) {
+            weights[i] = edges[i].weight;
+        }
+    }
+
+    u32 num_nodes() const {
+        return offsets.size() - 1;
+    }
+
+    I num_edges() const {
+        return weights.size();
+    }
+
+    /**
+     * Number of bytes used by the compressed graph
+     */
+    u64 memory_size() const {
+        return offsets.size() * sizeof(I) + target_offsets.size() * sizeof(u64) +
+               targets.size() + weights.size() * sizeof(W);
+    }
+
+    /**
+     * Calls f(id, to, weight) for every edge from u in sorted order
+     */
+    template<typename F>
+    void for_each_edge(u32 u, F f) const {
+        const u8* in = targets.begin() + target_offsets[u];
+        const W* edge_weights = weights.begin();
+        I begin = offsets[u];
+        I end = offsets[u + 1];
+
+        if (begin == end) return;
+
+        u64 value;
+        in = read_varint(in, value);
+        u32 to = u + static_cast<u32>((value >> 1) ^ (~(value & 1) + 1));
+        f(begin, to, edge_weights[begin]);
+
+        for (I i = begin + 1; i < end; ++i) {
+            in = read_varint(in, value);
+            to += static_cast<u32>(value);
+            f(i, to, edge_weights[i]);
+        }
+    }
+
+    static u64 delta(u32 from, bool first, u32 last, u32 to) {
+        if (first) {
+            /* zigzag, small negative differences become small positive numbers */
+            i64 difference = static_cast<i64>(to) - static_cast<i64>(from);
+            return (static_cast<u64>(difference) << 1) ^ static_cast<u64>(difference >> 63);
+        }
+        return to - last;
+    }
+
+    static u32 varint_size(u64 value) {
+        u32 size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            ++size;
+        }
+        return size;
+    }
+
+    static u8* write_varint(u8* out, u64 value) {
+        while (value >= 0x80) {
+            *out++ = static_cast<u8>(value) | 0x80;
+            value >>= 7;
+        }
+        *out++ = static_cast<u8>(value);
+        return out;
+    }
+
+    static const u8* read_varint(const u8* in, u64& value) {
+        /* Most differences fit into a single byte */
+        value = *in++;
+        if (value < 0x80) return in;
+
+        value &= 0x7F;
+        u32 shift = 7;
+        while (true) {
+            u64 byte = *in++;
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80) return in;
+            shift += 7;
+        }
+    }
+};
+
+using CompressedGraph = BasicCompressedGraph<>;
+
+#endif
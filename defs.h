@@ -5,6 +5,9 @@
 
 using u64 = uint64_t;
 using u32 = uint32_t;
+using u16 = uint16_t;
+using u8 = uint8_t;
+using i64 = int64_t;
 using atomic_u64 = std::atomic<u64>;
 using atomic_u32 = std::atomic<u32>;
 
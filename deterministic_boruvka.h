@@ -0,0 +1,112 @@
+#ifndef __DETERMINISTIC_BORUVKA_H
+#define __DETERMINISTIC_BORUVKA_H
+
+#include <algorithm>
+#include <omp.h>
+#include <parallel/algorithm>
+#include <parallel/numeric>
+#include <tuple>
+
+#include "defs.h"
+#include "graph.h"
+#include "parallel_array.h"
+#include "parallel_boruvka.h"
+
+/**
+ * Calculates the same MST for the same graph regardless of the number of threads and their timing
+ *
+ * ParallelBoruvkaMST breaks ties by edge ids in contracted graphs, and these depend on which nodes
+ * become DSU roots, which depends on timing. Here every edge gets the rank of its
+ * { weight, min(u, v), max(u, v) } among all edges instead of its weight. Both copies of an edge
+ * get the same rank and different edges get different ranks, so the MST is unique and
+ * ParallelBoruvkaMST finds it no matter how ties are broken inside. Edges which are equal in all
+ * three fields get the same rank, any of them gives the same output
+ *
+ * MST edges are returned as (min(u, v), max(u, v), weight), sorted by { weight, min, max }
+ *
+ * Graph edges must be sorted beforehand
+ */
+template<typename W = u32, typename I = u32>
+struct BasicDeterministicBoruvkaMST {
+    using Edge = BasicEdge<W>;
+    using Graph = BasicGraph<W, I>;
+    using RankedGraph = BasicGraph<I, I>;
+
+    ParallelArray<Edge> calculate_mst(const Graph& graph, u32 NUM_THREADS = omp_get_max_threads()) {
+        I num_edges = graph.num_edges();
+
+        if (graph.num_nodes() == 1) {
+            return ParallelArray<Edge>(0, NUM_THREADS);
+        }
+
+        /* { edge, id } sorted by canonical keys */
+        ParallelArray<std::pair<Edge, I>, I> canonical_edges(num_edges, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < num_edges; ++i) {
+            canonical_edges[i] = { graph.edges[i], i };
+        }
+
+        __gnu_parallel::sort(canonical_edges.begin(), canonical_edges.end(),
+                             [](const std::pair<Edge, I>& a, const std::pair<Edge, I>& b) {
+                                 return canonical_key(a.first) < canonical_key(b.first);
+                             });
+
+        /* Dense ranks, rank_prefix[i] - 1 is the rank of canonical_edges[i] */
+        ParallelArray<I, I> rank_starts(num_edges, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < num_edges; ++i) {
+            rank_starts[i] = i == 0 ||
+                             canonical_key(canonical_edges[i - 1].first) < canonical_key(canonical_edges[i].first);
+        }
+
+        ParallelArray<I, I> rank_prefix(num_edges, NUM_THREADS);
+        __gnu_parallel::partial_sum(rank_starts.begin(), rank_starts.end(), rank_prefix.begin());
+
+        /*
+         * Ranks grow with weights, so edges between the same nodes keep their order
+         * and the ranked graph is sorted as well
+         */
+        RankedGraph ranked_graph(graph.num_nodes(), num_edges);
+        ParallelArray<W, I> rank_weights(num_edges == 0 ? 0 : rank_prefix[num_edges - 1], NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_nodes(); ++i) {
+            ranked_graph.nodes[i] = graph.nodes[i];
+        }
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < num_edges; ++i) {
+            I rank = rank_prefix[i] - 1;
+            const Edge& e = graph.edges[canonical_edges[i].second];
+
+            ranked_graph.edges[canonical_edges[i].second] = BasicEdge<I>(e.from, e.to, rank);
+            if (rank_starts[i]) {
+                rank_weights[rank] = e.weight;
+            }
+        }
+
+        ParallelArray<BasicEdge<I>> ranked_mst =
+            BasicParallelBoruvkaMST<I, I>().calculate_mst(std::move(ranked_graph), NUM_THREADS);
+
+        __gnu_parallel::sort(ranked_mst.begin(), ranked_mst.end(),
+                             [](const BasicEdge<I>& a, const BasicEdge<I>& b) {
+                                 return a.weight < b.weight;
+                             });
+
+        ParallelArray<Edge> mst(ranked_mst.size(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < ranked_mst.size(); ++i) {
+            const BasicEdge<I>& e = ranked_mst[i];
+            mst[i] = Edge(std::min(e.from, e.to), std::max(e.from, e.to), rank_weights[e.weight]);
+        }
+
+        return mst;
+    }
+};
+
+using DeterministicBoruvkaMST = BasicDeterministicBoruvkaMST<>;
+
+#endif
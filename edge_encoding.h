@@ -0,0 +1,138 @@
+#ifndef __EDGE_ENCODING_H
+#define __EDGE_ENCODING_H
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "defs.h"
+
+/**
+ * INTERFACE:
+ *
+ * EdgeEncoding<W, I> - how the shortest edge of a node is stored in an atomic,
+ * W is the weight type and I is the edge id type
+ *
+ * Storage - type of the stored value
+ * NO_EDGE - value stored for nodes without edges
+ * Storage encode(I id, W weight) - encodes edge id with its weight
+ * I get_id(Storage encoded_edge) - decodes edge id
+ * bool less(Storage a, Storage b, const Edges& edges) - compares { weight, id } of encoded edges
+ *
+ * DETAILS:
+ *
+ * The encoding is chosen at compile time
+ *
+ * If the weight maps to an unsigned integer with the same order (integers, float, double)
+ * and together with the id fits into 64 bits, PackedEdgeEncoding is used.
+ * It is the same trick as in ParallelDSU: weight is stored in the high bits and id in the low bits,
+ * so comparing two values compares { weight, id } and less() is a single comparison.
+ * If both fit into 32 bits (e.g. u16 weights and ids), values are stored in u32,
+ * which halves the memory traffic
+ *
+ * Otherwise IndirectEdgeEncoding stores only the id and reads weights from the edge list.
+ * Edges are not modified while shortest edges are calculated, so a CAS loop on ids
+ * still finds the minimum, it just makes an extra load per comparison.
+ * This is used instead of a 128-bit CAS, which is not lock-free on every platform
+ *
+ * The largest id is reserved for NO_EDGE, so there can be at most 2^bits(I) - 1 edges
+ */
+
+/**
+ * Maps weights to unsigned integers with the same order
+ * Signed integers get their sign bit flipped, negative floats get all bits flipped
+ * and positive floats get their sign bit set
+ */
+template<typename W, typename Enable = void>
+struct WeightKey;
+
+template<typename W>
+struct WeightKey<W, std::enable_if_t<std::is_integral<W>::value>> {
+    using Key = std::make_unsigned_t<W>;
+
+    static Key to_key(W weight) {
+        Key key = static_cast<Key>(weight);
+        if (std::is_signed<W>::value) {
+            key ^= static_cast<Key>(1) << (8 * sizeof(Key) - 1);
+        }
+        return key;
+    }
+};
+
+template<typename W>
+struct WeightKey<W, std::enable_if_t<std::is_floating_point<W>::value && (sizeof(W) == 4 || sizeof(W) == 8)>> {
+    using Key = std::conditional_t<sizeof(W) == 4, u32, u64>;
+
+    static Key to_key(W weight) {
+        const Key SIGN_BIT = static_cast<Key>(1) << (8 * sizeof(Key) - 1);
+
+        Key key;
+        std::memcpy(&key, &weight, sizeof(key));
+        return (key & SIGN_BIT) ? ~key : key | SIGN_BIT;
+    }
+};
+
+template<typename W>
+constexpr bool is_packable_weight = std::is_integral<W>::value ||
+                                    std::is_same<W, float>::value ||
+                                    std::is_same<W, double>::value;
+
+template<typename W, typename I, typename S>
+struct PackedEdgeEncoding {
+    static_assert(std::is_unsigned<I>::value, "Edge ids must be unsigned");
+
+    using Storage = S;
+
+    static constexpr u32 ID_BITS = 8 * sizeof(I);
+    static constexpr Storage NO_EDGE = std::numeric_limits<Storage>::max();
+
+    static Storage encode(I id, W weight) {
+        return (static_cast<Storage>(WeightKey<W>::to_key(weight)) << ID_BITS) | id;
+    }
+
+    static I get_id(Storage encoded_edge) {
+        return static_cast<I>(encoded_edge);
+    }
+
+    template<typename Edges>
+    static bool less(Storage a, Storage b, const Edges&) {
+        return a < b;
+    }
+};
+
+template<typename W, typename I>
+struct IndirectEdgeEncoding {
+    static_assert(std::is_unsigned<I>::value, "Edge ids must be unsigned");
+
+    using Storage = I;
+
+    static constexpr Storage NO_EDGE = std::numeric_limits<Storage>::max();
+
+    static Storage encode(I id, W) {
+        return id;
+    }
+
+    static I get_id(Storage encoded_edge) {
+        return encoded_edge;
+    }
+
+    template<typename Edges>
+    static bool less(Storage a, Storage b, const Edges& edges) {
+        if (a == NO_EDGE) return false;
+        if (b == NO_EDGE) return true;
+
+        const W& weight_a = edges[a].weight;
+        const W& weight_b = edges[b].weight;
+
+        return weight_a < weight_b || (!(weight_b < weight_a) && a < b);
+    }
+};
+
+template<typename W, typename I, typename Enable = void>
+struct EdgeEncoding : IndirectEdgeEncoding<W, I> {};
+
+template<typename W, typename I>
+struct EdgeEncoding<W, I, std::enable_if_t<is_packable_weight<W> && sizeof(W) + sizeof(I) <= 8>>
+    : PackedEdgeEncoding<W, I, std::conditional_t<sizeof(W) + sizeof(I) <= 4, u32, u64>> {};
+
+#endif
@@ -4,43 +4,91 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <omp.h>
 #include <parallel/algorithm>
+#include <parallel/numeric>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>
 
 #include "defs.h"
 #include "parallel_array.h"
+#include "parallel_dsu.h"
 #include "utils.h"
 
-struct Edge {
+/**
+ * W is the weight type, nodes are always u32
+ */
+template<typename W>
+struct BasicEdge {
     u32 from;
     u32 to;
-    u32 weight;
+    W weight;
 
-    Edge() {}
+    BasicEdge() {}
 
-    Edge(u32 from, u32 to, u32 weight) : from(from), to(to), weight(weight) {}
+    BasicEdge(u32 from, u32 to, W weight) : from(from), to(to), weight(weight) {}
 };
 
-bool operator<(const Edge& a, const Edge& b) {
+template<typename W>
+bool operator<(const BasicEdge<W>& a, const BasicEdge<W>& b) {
     return std::tie(a.from, a.to, a.weight) < std::tie(b.from, b.to, b.weight);
 }
 
-struct Graph {
+using Edge = BasicEdge<u32>;
+
+/**
+ * Key of the undirected edge between u and v: { weight, min(u, v), max(u, v) }
+ * It is the same for both copies of an edge, so comparing keys breaks ties the same way everywhere
+ */
+template<typename W>
+std::tuple<W, u32, u32> canonical_key(u32 u, u32 v, const W& weight) {
+    return std::make_tuple(weight, std::min(u, v), std::max(u, v));
+}
+
+template<typename W>
+std::tuple<W, u32, u32> canonical_key(const BasicEdge<W>& e) {
+    return canonical_key(e.from, e.to, e.weight);
+}
+
+/**
+ * Edge of a contracted graph: from and to are components,
+ * original_from and original_to are the nodes of the input edge it came from
+ */
+template<typename W>
+struct ContractedEdge : BasicEdge<W> {
+    u32 original_from;
+    u32 original_to;
+
+    ContractedEdge() {}
+
+    ContractedEdge(u32 from, u32 to, W weight, u32 original_from, u32 original_to)
+        : BasicEdge<W>(from, to, weight), original_from(original_from), original_to(original_to) {}
+};
+
+/**
+ * W is the weight type and I is the edge id type,
+ * u64 ids allow graphs with more than 2^32 edges
+ * E is the edge type, input graphs use BasicEdge and contracted ones use ContractedEdge
+ */
+template<typename W = u32, typename I = u32, typename E = BasicEdge<W>>
+struct BasicGraph {
+    using EdgeType = E;
+
     ParallelArray<u32> nodes;
-    ParallelArray<Edge> edges;
+    ParallelArray<EdgeType, I> edges;
 
-    Graph(u32 num_nodes, u32 num_edges) : nodes(num_nodes),
-                                          edges(num_edges) {}
+    BasicGraph(u32 num_nodes, I num_edges) : nodes(num_nodes),
+                                             edges(num_edges) {}
 
     u32 num_nodes() const {
         return nodes.size();
     }
 
-    u32 num_edges() const {
+    I num_edges() const {
         return edges.size();
     }
 
@@ -49,6 +97,19 @@ struct Graph {
     }
 };
 
+using Graph = BasicGraph<>;
+
+/**
+ * Both directions of every edge are stored, so twice the number of edges in a file must fit into I
+ */
+template<typename I>
+I checked_num_edges(u64 num_edges) {
+    if (num_edges > std::numeric_limits<I>::max() / 2) {
+        throw std::invalid_argument("Too many edges for the edge id type: " + std::to_string(num_edges));
+    }
+    return num_edges;
+}
+
 /**
  * Loads a graph from given path
  * Graph format is:
@@ -59,29 +120,32 @@ struct Graph {
  * 
  * You only need to write each edge once
  **/
-Graph load_graph(std::string filename) {
+template<typename W = u32, typename I = u32>
+BasicGraph<W, I> load_graph(std::string filename) {
     std::cout << "Loading graph from path " << filename << "\n";
     std::ifstream in(filename);
 
     u32 num_nodes;
-    u32 num_edges;
+    u64 file_num_edges;
 
-    in >> num_nodes >> num_edges;
+    in >> num_nodes >> file_num_edges;
 
-    std::cout << num_nodes << " nodes and " << num_edges << " edges\n";
+    std::cout << num_nodes << " nodes and " << file_num_edges << " edges\n";
 
-    Graph G(num_nodes, num_edges * 2);
+    I num_edges = checked_num_edges<I>(file_num_edges);
+    BasicGraph<W, I> G(num_nodes, num_edges * 2);
 
     #pragma omp parallel for
     for (u32 i = 0; i < num_nodes; ++i) {
         G.nodes[i] = i;
     }
 
-    for (u32 i = 0; i < num_edges; ++i) {
-        u32 from, to, weight;
+    for (I i = 0; i < num_edges; ++i) {
+        u32 from, to;
+        W weight;
         in >> from >> to >> weight;
-        G.edges[2 * i] = Edge(from, to, weight);
-        G.edges[2 * i + 1] = Edge(to, from, weight);
+        G.edges[2 * i] = BasicEdge<W>(from, to, weight);
+        G.edges[2 * i + 1] = BasicEdge<W>(to, from, weight);
     }
 
     G.sort_edges();
@@ -126,30 +190,61 @@ Graph generate_graph(u32 n, u32 m) {
     return G;
 }
 
-void dfs(u32 u, std::vector<std::vector<u32>>& g, std::vector<u32>& used) {
-    used[u] = 1;
-    for (auto v : g[u]) {
-        if (used[v] == 0) dfs(v, g, used);
+struct ConnectedComponents {
+    u32 num_components;
+    ParallelArray<u32> labels;
+};
+
+/**
+ * Numbers the sets of a DSU with a prefix sum over their roots,
+ * so nodes get labels from 0 to num_components - 1
+ */
+ConnectedComponents label_components(ParallelDSU& node_sets, u32 NUM_THREADS = omp_get_max_threads()) {
+    u32 num_nodes = node_sets.size();
+    ConnectedComponents result{0, ParallelArray<u32>(num_nodes, NUM_THREADS)};
+
+    ParallelArray<u32> is_root(num_nodes, NUM_THREADS);
+
+    #pragma omp parallel for num_threads(NUM_THREADS)
+    for (u32 i = 0; i < num_nodes; ++i) {
+        is_root[i] = node_sets.find_root(i) == i;
+    }
+
+    ParallelArray<u32> is_root_prefix(num_nodes, NUM_THREADS);
+    __gnu_parallel::partial_sum(is_root.begin(), is_root.end(), is_root_prefix.begin());
+    result.num_components = is_root_prefix[num_nodes - 1];
+
+    #pragma omp parallel for num_threads(NUM_THREADS)
+    for (u32 i = 0; i < num_nodes; ++i) {
+        result.labels[i] = is_root_prefix[node_sets.find_root(i)] - 1;
     }
+
+    return result;
 }
 
-bool is_connected(Graph G) {
-    std::vector<std::vector<u32>> g(G.num_edges());
-    std::vector<u32> used(G.num_nodes());
-    for (auto e : G.edges) {
-        g[e.from].push_back(e.to);
-        g[e.to].push_back(e.from);
+/**
+ * Finds connected components of a graph without building an adjacency list
+ * Edges are merged in parallel with a ParallelDSU, then its sets are labeled
+ */
+template<typename W, typename I>
+ConnectedComponents connected_components(const BasicGraph<W, I>& G, u32 NUM_THREADS = omp_get_max_threads()) {
+    if (G.num_nodes() == 0) {
+        return ConnectedComponents{0, ParallelArray<u32>(0, NUM_THREADS)};
     }
 
-    u32 num_comp = 0;
-    for (u32 i = 0; i < G.num_nodes(); ++i) {
-        if (!used[i]) {
-            dfs(i, g, used);
-            ++num_comp;
-        }
+    ParallelDSU node_sets(G.num_nodes(), NUM_THREADS);
+
+    #pragma omp parallel for num_threads(NUM_THREADS)
+    for (I i = 0; i < G.num_edges(); ++i) {
+        node_sets.unite(G.edges[i].from, G.edges[i].to);
     }
 
-    return num_comp == 1;
+    return label_components(node_sets, NUM_THREADS);
+}
+
+template<typename W, typename I>
+bool is_connected(const BasicGraph<W, I>& G) {
+    return connected_components(G).num_components == 1;
 }
 
 #endif
@@ -0,0 +1,217 @@
+#ifndef __MST_CACHE_H
+#define __MST_CACHE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <omp.h>
+#include <stdexcept>
+#include <functional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+
+#include "defs.h"
+#include "deterministic_boruvka.h"
+#include "graph.h"
+#include "parallel_array.h"
+
+/**
+ * On-disk cache of MSTs keyed by the content hash of the graph
+ *
+ * MSTs are calculated with DeterministicBoruvkaMST, so a cached result is exactly
+ * what solving again would return. Each MST is stored in its own file named after the hash,
+ * it also holds sizes of the graph, which are checked on load along with the file size.
+ * Files are written to a temporary name unique to the process and thread and renamed, so concurrent
+ * jobs sharing a directory never read a partial file. Every cached edge is looked up in the graph,
+ * so hash collisions and stale files are noticed as well. Such files are treated as misses and rewritten
+ *
+ * Graphs which are not connected are cached with their spanning forests
+ *
+ * The hash is calculated in parallel over chunks of HASH_CHUNK_SIZE nodes or edges, which are then
+ * combined in order, so it does not depend on the number of threads
+ */
+template<typename W = u32, typename I = u32>
+struct BasicMSTCache {
+    static_assert(std::is_trivially_copyable<W>::value, "Weights are stored as raw bytes");
+
+    using Edge = BasicEdge<W>;
+    using Graph = BasicGraph<W, I>;
+
+    const u64 FILE_MAGIC = 0x3154534d4b565242ull;  /* "BRVKMST1" */
+    const u64 HASH_CHUNK_SIZE = 1 << 16;
+
+    std::string directory;
+    u64 num_hits = 0;
+    u64 num_misses = 0;
+
+    BasicMSTCache(std::string directory) : directory(directory) {
+        std::filesystem::create_directories(directory);
+    }
+
+    /**
+     * Returns the cached MST of the graph or calculates and stores it
+     */
+    ParallelArray<Edge> calculate_mst(const Graph& graph, u32 NUM_THREADS = omp_get_max_threads()) {
+        std::string path = file_path(hash_graph(graph, NUM_THREADS));
+        ParallelArray<Edge> mst(0, NUM_THREADS);
+
+        if (load(path, graph, mst)) {
+            ++num_hits;
+            return mst;
+        }
+
+        ++num_misses;
+        mst = BasicDeterministicBoruvkaMST<W, I>().calculate_mst(graph, NUM_THREADS);
+        store(path, graph, mst);
+
+        return mst;
+    }
+
+    std::string file_path(u64 hash) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.mst", static_cast<unsigned long long>(hash));
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    /**
+     * splitmix64 finalizer, every bit of the result depends on every bit of the input
+     */
+    static u64 mix(u64 value) {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ull;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebull;
+        value ^= value >> 31;
+        return value;
+    }
+
+    static u64 hash_combine(u64 hash, u64 value) {
+        return mix(hash ^ (value + 0x9e3779b97f4a7c15ull));
+    }
+
+    static u64 hash_weight(u64 hash, const W& weight) {
+        for (u32 offset = 0; offset < sizeof(W); offset += sizeof(u64)) {
+            u64 word = 0;
+            std::memcpy(&word, reinterpret_cast<const char*>(&weight) + offset,
+                        std::min<u64>(sizeof(u64), sizeof(W) - offset));
+            hash = hash_combine(hash, word);
+        }
+        return hash;
+    }
+
+    /**
+     * Hashes sizes, nodes and edges of the graph field by field, so padding is never read
+     */
+    u64 hash_graph(const Graph& graph, u32 NUM_THREADS = omp_get_max_threads()) {
+        u64 num_node_chunks = (graph.num_nodes() + HASH_CHUNK_SIZE - 1) / HASH_CHUNK_SIZE;
+        u64 num_edge_chunks = (graph.num_edges() + HASH_CHUNK_SIZE - 1) / HASH_CHUNK_SIZE;
+        ParallelArray<u64, u64> chunk_hashes(num_node_chunks + num_edge_chunks, NUM_THREADS);
+
+        #pragma omp parallel for schedule(dynamic) num_threads(NUM_THREADS)
+        for (u64 chunk = 0; chunk < num_node_chunks + num_edge_chunks; ++chunk) {
+            u64 hash = chunk;
+
+            if (chunk < num_node_chunks) {
+                u64 end = std::min<u64>(graph.num_nodes(), (chunk + 1) * HASH_CHUNK_SIZE);
+                for (u64 i = chunk * HASH_CHUNK_SIZE; i < end; ++i) {
+                    hash = hash_combine(hash, graph.nodes[i]);
+                }
+            } else {
+                u64 edge_chunk = chunk - num_node_chunks;
+                u64 end = std::min<u64>(graph.num_edges(), (edge_chunk + 1) * HASH_CHUNK_SIZE);
+                for (u64 i = edge_chunk * HASH_CHUNK_SIZE; i < end; ++i) {
+                    const Edge& e = graph.edges[i];
+                    hash = hash_combine(hash, (static_cast<u64>(e.from) << 32) | e.to);
+                    hash = hash_weight(hash, e.weight);
+                }
+            }
+
+            chunk_hashes[chunk] = hash;
+        }
+
+        u64 hash = hash_combine(hash_combine(0, graph.num_nodes()), graph.num_edges());
+        hash = hash_combine(hash, sizeof(W));
+        for (u64 chunk = 0; chunk < chunk_hashes.size(); ++chunk) {
+            hash = hash_combine(hash, chunk_hashes[chunk]);
+        }
+
+        return hash;
+    }
+
+    bool load(const std::string& path, const Graph& graph, ParallelArray<Edge>& mst) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+
+        u64 header[5];
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+
+        u64 mst_size = header[4];
+        /* A spanning forest has fewer edges than nodes */
+        if (header[0] != FILE_MAGIC || header[1] != sizeof(W) || header[2] != graph.num_nodes() ||
+            header[3] != graph.num_edges() || (mst_size != 0 && mst_size >= graph.num_nodes())) {
+            return false;
+        }
+
+        ParallelArray<Edge> result(mst_size);
+        for (u32 i = 0; i < mst_size; ++i) {
+            Edge& e = result[i];
+            in.read(reinterpret_cast<char*>(&e.from), sizeof(e.from));
+            in.read(reinterpret_cast<char*>(&e.to), sizeof(e.to));
+            in.read(reinterpret_cast<char*>(&e.weight), sizeof(e.weight));
+        }
+
+        /* Truncated files or files with extra bytes are not trusted */
+        if (!in || in.peek() != std::ifstream::traits_type::eof()) return false;
+
+        /* Same lookup as in BasicMSTVerifier::is_spanning_tree */
+        u32 num_missing_edges = 0;
+
+        #pragma omp parallel for reduction(+:num_missing_edges)
+        for (u32 i = 0; i < result.size(); ++i) {
+            const Edge& e = result[i];
+            const Edge* position = std::lower_bound(graph.edges.begin(), graph.edges.end(), e);
+
+            num_missing_edges += position == graph.edges.end() ||
+                                 std::tie(position->from, position->to, position->weight) !=
+                                 std::tie(e.from, e.to, e.weight);
+        }
+
+        if (num_missing_edges != 0) return false;
+
+        mst.swap(result);
+        return true;
+    }
+
+    void store(const std::string& path, const Graph& graph, const ParallelArray<Edge>& mst) {
+        std::string temporary_path = path + ".tmp" + std::to_string(getpid()) + "_" +
+                                     std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+        {
+            std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+            u64 header[5] = { FILE_MAGIC, sizeof(W), graph.num_nodes(), graph.num_edges(), mst.size() };
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+            for (u32 i = 0; i < mst.size(); ++i) {
+                const Edge& e = mst[i];
+                out.write(reinterpret_cast<const char*>(&e.from), sizeof(e.from));
+                out.write(reinterpret_cast<const char*>(&e.to), sizeof(e.to));
+                out.write(reinterpret_cast<const char*>(&e.weight), sizeof(e.weight));
+            }
+
+            if (!out) {
+                throw std::runtime_error("Cannot write MST cache file " + temporary_path);
+            }
+        }
+
+        std::filesystem::rename(temporary_path, path);
+    }
+};
+
+using MSTCache = BasicMSTCache<>;
+
+#endif
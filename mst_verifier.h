@@ -0,0 +1,264 @@
+#ifndef __MST_VERIFIER_H
+#define __MST_VERIFIER_H
+
+#include <algorithm>
+#include <limits>
+#include <omp.h>
+#include <parallel/algorithm>
+#include <parallel/numeric>
+#include <tuple>
+#include <vector>
+
+#include "defs.h"
+#include "graph.h"
+#include "parallel_array.h"
+#include "parallel_dsu.h"
+
+struct MSTVerification {
+    /* Candidate has N - 1 edges of the graph and connects all nodes */
+    bool is_spanning_tree;
+
+    /* Number of graph edges lighter than the heaviest tree edge on the path between their ends */
+    u64 num_light_edges;
+
+    bool is_mst() const {
+        return is_spanning_tree && num_light_edges == 0;
+    }
+};
+
+/**
+ * Checks that a candidate is an MST of the graph without calculating the MST again
+ *
+ * A spanning tree is minimal iff every graph edge (u, v) is at least as heavy as every tree edge
+ * on the path from u to v (cycle property). Edges of the tree pass this trivially, so the check
+ * is the same as checking that every non-tree edge is F-heavy, where F is the candidate
+ *
+ * The tree is rooted by a level-synchronous BFS, then every node gets 2^k-th ancestors and
+ * the heaviest edge on the way to them (binary lifting). After that all graph edges are
+ * independent path maximum queries, each of them in O(log depth). This is O(E log V / P)
+ * with no sorting of graph edges, instead of the O(E log^2 V / P) of solving again.
+ * Linear-time verification (Komlos, King) has much larger constants, so it is not used here
+ *
+ * Graph edges must be sorted beforehand, nodes must be 0 .. N - 1
+ */
+template<typename W = u32, typename I = u32>
+struct BasicMSTVerifier {
+    using Edge = BasicEdge<W>;
+    using Graph = BasicGraph<W, I>;
+
+    const u32 NO_NODE = std::numeric_limits<u32>::max();
+
+    /* 2^k-th ancestor of a node and the heaviest edge on the way to it, stored together for locality */
+    struct Jump {
+        u32 ancestor;
+        W heaviest;
+    };
+
+    MSTVerification verify(const Graph& graph, const ParallelArray<Edge>& mst,
+                           u32 NUM_THREADS = omp_get_max_threads()) {
+        MSTVerification result{false, 0};
+
+        if (!is_spanning_tree(graph, mst, NUM_THREADS)) {
+            return result;
+        }
+        result.is_spanning_tree = true;
+
+        u32 num_nodes = graph.num_nodes();
+        if (num_nodes == 1) {
+            return result;
+        }
+
+        /* jumps[k][v] - jump from v by 2^k edges towards the root */
+        std::vector<ParallelArray<Jump>> jumps;
+        jumps.emplace_back(num_nodes, NUM_THREADS);
+
+        ParallelArray<u32> depths(num_nodes, NUM_THREADS);
+        u32 max_depth = root_tree(mst, num_nodes, jumps[0], depths, NUM_THREADS);
+
+        u32 num_levels = 1;
+        while ((1u << num_levels) <= max_depth) ++num_levels;
+
+        for (u32 k = 1; k < num_levels; ++k) {
+            jumps.emplace_back(num_nodes, NUM_THREADS);
+
+            const ParallelArray<Jump>& lower = jumps[k - 1];
+            ParallelArray<Jump>& upper = jumps[k];
+
+            #pragma omp parallel for num_threads(NUM_THREADS)
+            for (u32 v = 0; v < num_nodes; ++v) {
+                const Jump& middle = lower[lower[v].ancestor];
+                upper[v] = { middle.ancestor, std::max(lower[v].heaviest, middle.heaviest) };
+            }
+        }
+
+        u64 num_light_edges = 0;
+
+        #pragma omp parallel for reduction(+:num_light_edges) num_threads(NUM_THREADS)
+        for (I i = 0; i < graph.num_edges(); ++i) {
+            const Edge& e = graph.edges[i];
+
+            /* Both copies of an edge give the same answer */
+            if (e.from < e.to) {
+                num_light_edges += e.weight < path_maximum(jumps, depths, e.from, e.to);
+            }
+        }
+
+        result.num_light_edges = num_light_edges;
+        return result;
+    }
+
+    /**
+     * Checks that the candidate has N - 1 edges, all of them are in the graph,
+     * and they connect all nodes (so there are no cycles)
+     */
+    bool is_spanning_tree(const Graph& graph, const ParallelArray<Edge>& mst, u32 NUM_THREADS) {
+        u32 num_nodes = graph.num_nodes();
+
+        if (num_nodes == 0 || mst.size() != num_nodes - 1) {
+            return false;
+        }
+
+        u32 num_missing_edges = 0;
+
+        #pragma omp parallel for reduction(+:num_missing_edges) num_threads(NUM_THREADS)
+        for (u32 i = 0; i < mst.size(); ++i) {
+            const Edge& e = mst[i];
+            const Edge* position = std::lower_bound(graph.edges.begin(), graph.edges.end(), e);
+
+            num_missing_edges += e.from >= num_nodes || e.to >= num_nodes || position == graph.edges.end() ||
+                                 std::tie(position->from, position->to, position->weight) !=
+                                 std::tie(e.from, e.to, e.weight);
+        }
+
+        if (num_missing_edges != 0) {
+            return false;
+        }
+
+        ParallelDSU node_sets(num_nodes, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < mst.size(); ++i) {
+            node_sets.unite(mst[i].from, mst[i].to);
+        }
+
+        u32 num_roots = 0;
+
+        #pragma omp parallel for reduction(+:num_roots) num_threads(NUM_THREADS)
+        for (u32 v = 0; v < num_nodes; ++v) {
+            num_roots += node_sets.find_root(v) == v;
+        }
+
+        return num_roots == 1;
+    }
+
+    /**
+     * Roots the tree at node 0 with a level-synchronous BFS and returns its depth
+     * The root is its own parent, so jumps past the root stay there
+     */
+    u32 root_tree(const ParallelArray<Edge>& mst, u32 num_nodes, ParallelArray<Jump>& parents,
+                  ParallelArray<u32>& depths, u32 NUM_THREADS) {
+        /* Both directions of tree edges, sorted by from */
+        ParallelArray<Edge> adjacent(2 * mst.size(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < mst.size(); ++i) {
+            adjacent[2 * i] = mst[i];
+            adjacent[2 * i + 1] = Edge(mst[i].to, mst[i].from, mst[i].weight);
+        }
+
+        __gnu_parallel::sort(adjacent.begin(), adjacent.end());
+
+        ParallelArray<u32> offsets(num_nodes + 1, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 v = 0; v <= num_nodes; ++v) {
+            offsets[v] = std::lower_bound(adjacent.begin(), adjacent.end(), v,
+                                          [](const Edge& e, u32 node) { return e.from < node; }) - adjacent.begin();
+            if (v < num_nodes) parents[v].ancestor = NO_NODE;
+        }
+
+        parents[0] = { 0, std::numeric_limits<W>::lowest() };
+        depths[0] = 0;
+
+        ParallelArray<u32> frontier(num_nodes, NUM_THREADS);
+        ParallelArray<u32> next_frontier(num_nodes, NUM_THREADS);
+        ParallelArray<u32> num_children(num_nodes + 1, NUM_THREADS);
+        ParallelArray<u32> num_children_prefix(num_nodes + 1, NUM_THREADS);
+        u32 frontier_size = 1;
+        u32 depth = 0;
+        frontier[0] = 0;
+        num_children[0] = 0;
+
+        while (true) {
+            #pragma omp parallel for num_threads(NUM_THREADS)
+            for (u32 i = 0; i < frontier_size; ++i) {
+                u32 v = frontier[i];
+                num_children[i + 1] = offsets[v + 1] - offsets[v] - (v != 0);
+            }
+
+            __gnu_parallel::partial_sum(num_children.begin(), num_children.begin() + frontier_size + 1,
+                                        num_children_prefix.begin());
+
+            u32 next_frontier_size = num_children_prefix[frontier_size];
+            if (next_frontier_size == 0) break;
+
+            ++depth;
+
+            #pragma omp parallel for schedule(guided) num_threads(NUM_THREADS)
+            for (u32 i = 0; i < frontier_size; ++i) {
+                u32 v = frontier[i];
+                u32 position = num_children_prefix[i];
+
+                for (u32 j = offsets[v]; j < offsets[v + 1]; ++j) {
+                    u32 child = adjacent[j].to;
+                    if (child == parents[v].ancestor) continue;
+
+                    parents[child] = { v, adjacent[j].weight };
+                    depths[child] = depth;
+                    next_frontier[position++] = child;
+                }
+            }
+
+            frontier.swap(next_frontier);
+            frontier_size = next_frontier_size;
+        }
+
+        return depth;
+    }
+
+    /**
+     * Heaviest tree edge on the path from u to v, u != v
+     */
+    W path_maximum(const std::vector<ParallelArray<Jump>>& jumps, const ParallelArray<u32>& depths, u32 u, u32 v) {
+        W result = std::numeric_limits<W>::lowest();
+
+        if (depths[u] < depths[v]) std::swap(u, v);
+
+        u32 difference = depths[u] - depths[v];
+        for (u32 k = 0; difference != 0; ++k, difference >>= 1) {
+            if (difference & 1) {
+                result = std::max(result, jumps[k][u].heaviest);
+                u = jumps[k][u].ancestor;
+            }
+        }
+
+        if (u == v) return result;
+
+        for (u32 k = jumps.size(); k-- > 0;) {
+            const Jump& jump_u = jumps[k][u];
+            const Jump& jump_v = jumps[k][v];
+
+            if (jump_u.ancestor != jump_v.ancestor) {
+                result = std::max(result, std::max(jump_u.heaviest, jump_v.heaviest));
+                u = jump_u.ancestor;
+                v = jump_v.ancestor;
+            }
+        }
+
+        return std::max(result, std::max(jumps[0][u].heaviest, jumps[0][v].heaviest));
+    }
+};
+
+using MSTVerifier = BasicMSTVerifier<>;
+
+#endif
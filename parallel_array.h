@@ -6,65 +6,87 @@
 
 #include "defs.h"
 
-template<typename T>
+/**
+ * I is the index type, u64 allows arrays with more than 2^32 elements
+ */
+template<typename T, typename I = u32>
 struct ParallelArray {
     const u32 NUM_THREADS;
 
-    u32 arr_size;
+    I arr_size;
     T* data;
 
-    ParallelArray(u32 arr_size, u32 NUM_THREADS = omp_get_max_threads()) : NUM_THREADS(NUM_THREADS),
+    ParallelArray(I arr_size, u32 NUM_THREADS = omp_get_max_threads()) : NUM_THREADS(NUM_THREADS),
                                                                            arr_size(arr_size) {
         data = static_cast<T*>(operator new[] (arr_size * sizeof(T)));
     }
 
-    ParallelArray(ParallelArray<T>& other) : NUM_THREADS(other.NUM_THREADS),
+    ParallelArray(ParallelArray<T, I>& other) : NUM_THREADS(other.NUM_THREADS),
                                                 arr_size(other.arr_size) {
         data = static_cast<T*>(operator new[] (arr_size * sizeof(T)));
 
         #pragma omp parallel for num_threads(NUM_THREADS)
-        for (u32 i = 0; i < arr_size; ++i) {
+        for (I i = 0; i < arr_size; ++i) {
             data[i] = other.data[i];
         }
     }
 
-    ParallelArray(ParallelArray<T>&& other) : NUM_THREADS(other.NUM_THREADS) {
+    ParallelArray(ParallelArray<T, I>&& other) noexcept : NUM_THREADS(other.NUM_THREADS),
+                                                      arr_size(0),
+                                                      data(nullptr) {
         std::swap(arr_size, other.arr_size);
         std::swap(data, other.data);
     }
 
-    ParallelArray<T>& operator=(const ParallelArray<T>& other) {
+    ParallelArray<T, I>& operator=(const ParallelArray<T, I>& other) {
         delete[] data;
         arr_size = other.arr_size;
         data = static_cast<T*>(operator new[] (arr_size * sizeof(T)));
 
         #pragma omp parallel for num_threads(NUM_THREADS)
-        for (u32 i = 0; i < arr_size; ++i) {
+        for (I i = 0; i < arr_size; ++i) {
             data[i] = other.data[i];
         }
 
         return *this;
     }
 
-    u32 size() const {
+    ParallelArray<T, I>& operator=(ParallelArray<T, I>&& other) noexcept {
+        std::swap(arr_size, other.arr_size);
+        std::swap(data, other.data);
+
+        return *this;
+    }
+
+    I size() const {
         return arr_size;
     }
 
-    const T& operator[](u32 id) const {
+    const T& operator[](I id) const {
         if (id >= arr_size) {
             throw std::out_of_range("Parallel array id out of range");
         }
         return data[id];
     }
 
-    T& operator[](u32 id) {
+    T& operator[](I id) {
         if (id >= arr_size) {
             throw std::out_of_range("Parallel array id out of range");
         }
         return data[id];
     }
 
-    void swap(ParallelArray<T> other) {
+    /**
+     * Drops the elements from new_size on, memory is not reallocated
+     */
+    void shrink(I new_size) {
+        if (new_size > arr_size) {
+            throw std::invalid_argument("Shrinking parallel array to a bigger size");
+        }
+        arr_size = new_size;
+    }
+
+    void swap(ParallelArray<T, I>& other) {
         if (this == &other) {
             throw std::invalid_argument("Swapping with the same ParallelArray");
         }
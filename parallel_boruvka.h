@@ -2,171 +2,555 @@
 #define __BORUVKA_H
 
 #include <algorithm>
+#include <fstream>
+#include <iostream>
 #include <limits>
 #include <omp.h>
 #include <parallel/algorithm>
 #include <parallel/numeric>
+#include <string>
+#include <thread>
 #include <unordered_map>
 
+#include "compressed_graph.h"
+#include "edge_encoding.h"
 #include "parallel_dsu.h"
 #include "graph.h"
 #include "parallel_array.h"
 
-struct ParallelBoruvkaMST {
+/**
+ * W is the weight type and I is the edge id type
+ * Shortest edges are stored in the encoding chosen for them by EdgeEncoding<W, I>
+ */
+template<typename W = u32, typename I = u32>
+struct BasicParallelBoruvkaMST {
+    using Edge = BasicEdge<W>;
+    using Graph = BasicGraph<W, I>;
+    using ContractedGraph = BasicGraph<W, I, ContractedEdge<W>>;
+    using Encoding = EdgeEncoding<W, I>;
+    using EncodedEdge = typename Encoding::Storage;
+    using ShortestEdges = ParallelArray<std::atomic<EncodedEdge>>;
+
+    /* Node has no edges, no real edge has this value */
+    const EncodedEdge NO_EDGE = Encoding::NO_EDGE;
+
+    /* Number of input edges parsed at once by calculate_mst_from_file */
+    const u32 LOAD_CHUNK_SIZE = 1 << 16;
+
+    EncodedEdge encode_edge(I id, W weight) {
+        return Encoding::encode(id, weight);
+    }
+
+    I get_id(EncodedEdge encoded_edge) {
+        return Encoding::get_id(encoded_edge);
+    }
+
+    /**
+     * Compares { weight, id } of two encoded edges of the graph
+     */
+    template<typename G>
+    bool edge_less(EncodedEdge a, EncodedEdge b, const G& graph) {
+        return Encoding::less(a, b, graph.edges);
+    }
+
+    /**
+     * Input edge which became the given edge, contracted edges keep its nodes
+     */
+    static Edge original_edge(const Edge& e) {
+        return e;
+    }
+
+    static Edge original_edge(const ContractedEdge<W>& e) {
+        return Edge(e.original_from, e.original_to, e.weight);
+    }
+
     /**
-     * I use the same atomic pair that I use in dsu.h
+     * Calculates the shortest edge from each node of the graph
+     * Graph edges must be sorted beforehand
+     * G is Graph or ContractedGraph, here and in the functions below
      */
-    const u32 EDGE_BINARY_BUCKET_SIZE = 32;
-    const u64 EDGE_WEIGHT_MASK = 0xFFFFFFFF00000000ULL;
+    template<typename G>
+    void calculate_shortest_edges(const G& graph, ShortestEdges& shortest_edges, u32 NUM_THREADS) {
+        u32 initial_num_nodes = shortest_edges.size();
+
+        #pragma omp parallel num_threads(NUM_THREADS)
+        {
+            ParallelArray<std::pair<W, I>> local_shortest_edges(initial_num_nodes);
+            ParallelArray<u32> local_nodes(graph.num_nodes());
+            u32 local_size = 0;
+            u32 last_node = initial_num_nodes + 1;  /* Assuming there is no node bigger than N in G */
+
+            for (u32 i = 0; i < graph.num_nodes(); ++i) {
+                shortest_edges[graph.nodes[i]] = NO_EDGE;
+            }
+
+            #pragma omp for
+            for (I i = 0; i < graph.num_edges(); ++i) {
+                const auto& e = graph.edges[i];
+
+                if (e.from != last_node || local_shortest_edges[e.from].first > e.weight) {
+                    local_shortest_edges[e.from] = { e.weight, i };
+                    if (e.from != last_node) {
+                        local_nodes[local_size++] = e.from;
+                        last_node = e.from;
+                    }
+                }
+            }
+
+            for (u32 i = 0; i < local_size; ++i) { /* O(M / p) operations in each thread */
+                u32 node = local_nodes[i];
+                EncodedEdge old = shortest_edges[node];
+                auto shortest_edge = local_shortest_edges[node];
 
-    u64 encode_edge(u32 id, u32 weight) {
-        return (static_cast<u64>(weight) << EDGE_BINARY_BUCKET_SIZE) | id;
+                /* p.second = { weight, id } */
+                EncodedEdge encoded_edge = encode_edge(shortest_edge.second, shortest_edge.first);
+
+                /* 
+                 * Atomic minimum of { weight, id }, on failure old is reloaded by CAS
+                 * Equal weights are resolved by id, so every thread breaks ties the same way
+                 * This loop is wait-free
+                 */
+                while (edge_less(encoded_edge, old, graph) &&
+                       !shortest_edges[node].compare_exchange_weak(old, encoded_edge)) {}
+            }
+        }
     }
 
-    u32 get_id(u64 encoded_edge) {
-        return static_cast<u32>(encoded_edge);
+    /**
+     * Checks if the shortest edge from u is added to MST
+     * If the shortest edges from u and v lead to each other, only the one from the smaller node is added
+     * Only edges smaller than the edge encoded in limit in { weight, id } order are selected,
+     * NO_EDGE selects all of them
+     */
+    template<typename G>
+    bool is_selected(const G& graph, ShortestEdges& shortest_edges, u32 u, EncodedEdge limit) {
+        if (shortest_edges[u] == NO_EDGE) return false;
+
+        const auto& e = graph.edges[get_id(shortest_edges[u])];
+        if (limit != NO_EDGE && !edge_less(shortest_edges[u], limit, graph)) return false;
+
+        u32 v = e.to;
+
+        /* If smallest edge from v goes to u or u < v */
+        return graph.edges[get_id(shortest_edges[v])].to != u || u < v;
     }
 
-    u32 get_weight(u64 encoded_edge) {
-        return static_cast<u32>(encoded_edge >> EDGE_BINARY_BUCKET_SIZE);
+    /**
+     * Adds the shortest edges to MST, merges their components and writes the contracted graph
+     * to contracted, which may be graph itself
+     * Edges of the contracted graph connect components and keep the nodes of the input edges,
+     * so MST always gets input edges
+     * Only the shortest edges are used here, so graph edges do not have to be sorted,
+     * edges of the contracted graph are sorted for the next round
+     */
+    template<typename G>
+    void contract(const G& graph, ContractedGraph& contracted, ShortestEdges& shortest_edges,
+                  ParallelDSU& node_sets, ParallelArray<Edge>& mst, u32& current_mst_size, u32 NUM_THREADS) {
+        contract(graph, contracted, shortest_edges, node_sets, mst, current_mst_size, NO_EDGE, NUM_THREADS);
+    }
+
+    /**
+     * Same as above, but only shortest edges smaller than limit are added (see is_selected)
+     */
+    template<typename G>
+    void contract(const G& graph, ContractedGraph& contracted, ShortestEdges& shortest_edges,
+                  ParallelDSU& node_sets, ParallelArray<Edge>& mst, u32& current_mst_size, EncodedEdge limit,
+                  u32 NUM_THREADS) {
+        /* Calculating selected edges */
+        ParallelArray<I, I> edge_selected(graph.num_edges(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < graph.num_edges(); ++i) {
+            edge_selected[i] = 0;
+        }
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_nodes(); ++i) {
+            u32 u = graph.nodes[i];
+
+            if (is_selected(graph, shortest_edges, u, limit)) {
+                u32 v = graph.edges[get_id(shortest_edges[u])].to;
+                node_sets.unite(u, v);
+                edge_selected[get_id(shortest_edges[u])] = true;
+            }
+        }
+
+        /* Adding edges to MST */
+        ParallelArray<I, I> edge_selected_prefix(graph.num_edges(), NUM_THREADS);
+        __gnu_parallel::partial_sum(edge_selected.begin(), edge_selected.end(), edge_selected_prefix.begin());
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < graph.num_edges(); ++i) {
+            if (edge_selected[i]) {
+                mst[current_mst_size + edge_selected_prefix[i] - 1] = original_edge(graph.edges[i]);
+            }
+        }
+        current_mst_size += graph.num_edges() == 0 ? 0 : edge_selected_prefix[graph.num_edges() - 1];
+
+        /* Calculating remaining edges */
+        ParallelArray<I, I> edge_remains(graph.num_edges(), NUM_THREADS);
+        #pragma omp parallel for
+        for (I i = 0; i < graph.num_edges(); ++i) {
+            edge_remains[i] = !node_sets.same_set(graph.edges[i].from, graph.edges[i].to);
+        }
+
+        ParallelArray<I, I> edge_remains_prefix(graph.num_edges(), NUM_THREADS);
+        __gnu_parallel::partial_sum(edge_remains.begin(), edge_remains.end(), edge_remains_prefix.begin());
+        I num_new_edges = graph.num_edges() == 0 ? 0 : edge_remains_prefix[graph.num_edges() - 1];
+        ParallelArray<ContractedEdge<W>, I> new_edges(num_new_edges, NUM_THREADS);
+            
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (I i = 0; i < graph.num_edges(); ++i) {
+            if (edge_remains[i]) {
+                Edge old_edge = original_edge(graph.edges[i]);
+                new_edges[edge_remains_prefix[i] - 1] = ContractedEdge<W>(node_sets.find_root(graph.edges[i].from),
+                                                                          node_sets.find_root(graph.edges[i].to),
+                                                                          old_edge.weight,
+                                                                          old_edge.from,
+                                                                          old_edge.to);
+            }
+        }
+            
+        /* Calculating remaining nodes */
+        ParallelArray<u32> node_remains(graph.num_nodes(), NUM_THREADS);
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_nodes(); ++i) {
+            node_remains[i] = (
+                node_sets.find_root(graph.nodes[i]) == graph.nodes[i]
+            );
+        }
+
+        ParallelArray<u32> node_remains_prefix(graph.num_nodes(), NUM_THREADS);
+        __gnu_parallel::partial_sum(node_remains.begin(), node_remains.end(), node_remains_prefix.begin());
+        ParallelArray<u32> new_nodes(node_remains_prefix[graph.num_nodes() - 1]);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_nodes(); ++i) {
+            if (node_remains[i]) {
+                new_nodes[node_remains_prefix[i] - 1] = graph.nodes[i];
+            }
+        }
+
+        /* Swapping old graph for new graph */
+        contracted.nodes.swap(new_nodes);
+        contracted.edges.swap(new_edges);
+        contracted.sort_edges();
+    }
+
+    /**
+     * Runs Boruvka rounds on graph in place until a single node is left
+     * If the input is not connected, rounds stop when no edges are left and
+     * mst is shrunk to the spanning forest
+     */
+    void contract_until_single_node(ContractedGraph& graph, ParallelDSU& node_sets, ParallelArray<Edge>& mst,
+                                    u32& current_mst_size, u32 initial_num_nodes, u32 NUM_THREADS) {
+        while (graph.num_nodes() != 1 && graph.num_edges() != 0) {
+            ShortestEdges shortest_edges(initial_num_nodes, NUM_THREADS);
+
+            calculate_shortest_edges(graph, shortest_edges, NUM_THREADS);
+            contract(graph, graph, shortest_edges, node_sets, mst, current_mst_size, NUM_THREADS);
+        }
+
+        mst.shrink(current_mst_size);
     }
 
     /**
      * Calculates MST of given graph and returns a ParallelArray<Edge> object
      * Graph edges must be sorted beforehand
+     * If the graph is not connected, its spanning forest is returned
+     * 
+     * The graph is only read: the first round contracts it into a graph owned
+     * by the engine, and all other rounds work with that one, so nothing is copied
      */
-    ParallelArray<Edge> calculate_mst(Graph graph, u32 NUM_THREADS = omp_get_max_threads()) {
+    ParallelArray<Edge> calculate_mst(const Graph& graph, u32 NUM_THREADS = omp_get_max_threads()) {
         ParallelDSU node_sets(graph.num_nodes(), NUM_THREADS);
         ParallelArray<Edge> mst(graph.num_nodes() - 1, NUM_THREADS);
         u32 current_mst_size = 0;
         u32 initial_num_nodes = graph.num_nodes();
 
-        while (graph.num_nodes() != 1) {
-            ParallelArray<atomic_u64> shortest_edges(initial_num_nodes, NUM_THREADS);
+        if (graph.num_nodes() == 1) {
+            return mst;
+        }
 
-            /* Calculating shortest edges from each node */
-            #pragma omp parallel num_threads(NUM_THREADS)
-            {
-                ParallelArray<std::pair<u32, u32>> local_shortest_edges(initial_num_nodes);
-                ParallelArray<u32> local_nodes(graph.num_nodes());
-                u32 local_size = 0;
-                u32 last_node = initial_num_nodes + 1;  /* Assuming there is no node bigger than N in G */
+        ContractedGraph contracted(0, 0);
+        {
+            ShortestEdges shortest_edges(initial_num_nodes, NUM_THREADS);
 
-                for (u32 i = 0; i < graph.num_nodes(); ++i) {
-                    shortest_edges[graph.nodes[i]] = encode_edge(0, std::numeric_limits<u32>::max());
-                }
+            calculate_shortest_edges(graph, shortest_edges, NUM_THREADS);
+            contract(graph, contracted, shortest_edges, node_sets, mst, current_mst_size, NUM_THREADS);
+        }
 
-                #pragma omp for
-                for (u32 i = 0; i < graph.num_edges(); ++i) {
-                    const Edge& e = graph.edges[i];
+        contract_until_single_node(contracted, node_sets, mst, current_mst_size, initial_num_nodes, NUM_THREADS);
 
-                    if (e.from != last_node || local_shortest_edges[e.from].first > e.weight) {
-                        local_shortest_edges[e.from] = { e.weight, i };
-                        if (e.from != last_node) {
-                            local_nodes[local_size++] = e.from;
-                            last_node = e.from;
-                        }
-                    }
-                }
+        return mst;
+    }
 
-                for (u32 i = 0; i < local_size; ++i) { /* O(M / p) operations in each thread */
-                    u32 node = local_nodes[i];
-                    u64 old = shortest_edges[node];
-                    auto shortest_edge = local_shortest_edges[node];
+    /**
+     * Same as above, but consumes the graph, its memory is released right after the first round
+     * Use as calculate_mst(std::move(graph)) when the graph is no longer needed
+     *
+     * Contracted edges are wider than input edges (they keep the input nodes), so the first round
+     * cannot write into the input, but peak memory is the same as when contracting in place:
+     * the input and the first contracted graph are alive together only during the first round
+     */
+    ParallelArray<Edge> calculate_mst(Graph&& graph, u32 NUM_THREADS = omp_get_max_threads()) {
+        u32 initial_num_nodes = graph.num_nodes();
+        ParallelDSU node_sets(initial_num_nodes, NUM_THREADS);
+        ParallelArray<Edge> mst(initial_num_nodes - 1, NUM_THREADS);
+        u32 current_mst_size = 0;
+
+        if (initial_num_nodes == 1) {
+            return mst;
+        }
 
-                    /* p.second = { weight, id } */
-                    u64 encoded_edge = encode_edge(shortest_edge.second, shortest_edge.first);
+        ContractedGraph contracted(0, 0);
+        {
+            ShortestEdges shortest_edges(initial_num_nodes, NUM_THREADS);
 
-                    while (true) { /* This loop is wait-free */
-                        if (get_weight(old) < shortest_edge.first ||
-                            shortest_edges[node].compare_exchange_strong(old, encoded_edge)) {
-                            break;
-                        }
-                    }
+            calculate_shortest_edges(graph, shortest_edges, NUM_THREADS);
+            contract(graph, contracted, shortest_edges, node_sets, mst, current_mst_size, NUM_THREADS);
+        }
+
+        graph.nodes = ParallelArray<u32>(0);
+        graph.edges = ParallelArray<Edge, I>(0);
+
+        contract_until_single_node(contracted, node_sets, mst, current_mst_size, initial_num_nodes, NUM_THREADS);
+
+        return mst;
+    }
+
+    /**
+     * Same as above, but for a compressed graph, which is only read
+     *
+     * The first round runs on the compressed edges: every node decodes its own edges,
+     * so the shortest edges are found without atomics, and the same pass after the merges
+     * writes the contracted graph. It is usually several times smaller than the input,
+     * so the other rounds use the uncompressed graph owned by the engine
+     *
+     * Edges of a node are in sorted order, so the first of the lightest ones has the smallest id
+     * and the same edges are selected as in the uncompressed version
+     */
+    ParallelArray<Edge> calculate_mst(const BasicCompressedGraph<W, I>& graph, u32 NUM_THREADS = omp_get_max_threads()) {
+        u32 num_nodes = graph.num_nodes();
+        const I NO_ID = std::numeric_limits<I>::max();
+
+        ParallelDSU node_sets(num_nodes, NUM_THREADS);
+        ParallelArray<Edge> mst(num_nodes - 1, NUM_THREADS);
+        u32 current_mst_size = 0;
+
+        if (num_nodes == 1) {
+            return mst;
+        }
+
+        /* Calculating shortest edges */
+        ParallelArray<I> shortest_ids(num_nodes, NUM_THREADS);
+        ParallelArray<u32> shortest_to(num_nodes, NUM_THREADS);
+        ParallelArray<W> shortest_weights(num_nodes, NUM_THREADS);
+
+        #pragma omp parallel for schedule(guided) num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            I shortest_id = NO_ID;
+
+            graph.for_each_edge(u, [&](I id, u32 to, const W& weight) {
+                if (shortest_id == NO_ID || weight < shortest_weights[u]) {
+                    shortest_id = id;
+                    shortest_to[u] = to;
+                    shortest_weights[u] = weight;
                 }
+            });
+
+            shortest_ids[u] = shortest_id;
+        }
+
+        /* Adding edges to MST, same rule as in is_selected */
+        ParallelArray<u32> node_selected(num_nodes, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            u32 v = shortest_to[u];
+            node_selected[u] = shortest_ids[u] != NO_ID && (shortest_to[v] != u || u < v);
+
+            if (node_selected[u]) {
+                node_sets.unite(u, v);
             }
+        }
 
-            /* Calculating selected edges */
-            ParallelArray<u32> edge_selected(graph.num_edges(), NUM_THREADS);
+        ParallelArray<u32> node_selected_prefix(num_nodes, NUM_THREADS);
+        __gnu_parallel::partial_sum(node_selected.begin(), node_selected.end(), node_selected_prefix.begin());
 
-            #pragma omp parallel for num_threads(NUM_THREADS)
-            for (u32 i = 0; i < graph.num_edges(); ++i) {
-                edge_selected[i] = 0;
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            if (node_selected[u]) {
+                mst[node_selected_prefix[u] - 1] = Edge(u, shortest_to[u], shortest_weights[u]);
             }
+        }
+        current_mst_size = node_selected_prefix[num_nodes - 1];
 
-            #pragma omp parallel for num_threads(NUM_THREADS)
-            for (u32 i = 0; i < graph.num_nodes(); ++i) {
-                u32 u = graph.nodes[i];
-                u32 v = graph.edges[get_id(shortest_edges[u])].to;
-                
-                /* If smallest edge from v goes to u or u < v */
-                if (graph.edges[get_id(shortest_edges[v])].to != u || u < v) { 
-                    node_sets.unite(u, v);
-                    edge_selected[get_id(shortest_edges[u])] = true;
+        /* Calculating remaining edges, first their number for every node */
+        ParallelArray<u32> roots(num_nodes, NUM_THREADS);
+        ParallelArray<I, I> edges_remain(num_nodes + 1, NUM_THREADS);
+        edges_remain[0] = 0;
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            roots[u] = node_sets.find_root(u);
+        }
+
+        #pragma omp parallel for schedule(guided) num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            I count = 0;
+            graph.for_each_edge(u, [&](I, u32 to, const W&) {
+                count += roots[u] != roots[to];
+            });
+            edges_remain[u + 1] = count;
+        }
+
+        ParallelArray<I, I> edges_remain_prefix(num_nodes + 1, NUM_THREADS);
+        __gnu_parallel::partial_sum(edges_remain.begin(), edges_remain.end(), edges_remain_prefix.begin());
+
+        ContractedGraph contracted(0, 0);
+        ParallelArray<ContractedEdge<W>, I> new_edges(edges_remain_prefix[num_nodes], NUM_THREADS);
+
+        #pragma omp parallel for schedule(guided) num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            I position = edges_remain_prefix[u];
+            graph.for_each_edge(u, [&](I, u32 to, const W& weight) {
+                if (roots[u] != roots[to]) {
+                    new_edges[position++] = ContractedEdge<W>(roots[u], roots[to], weight, u, to);
                 }
+            });
+        }
+
+        /* Calculating remaining nodes */
+        ParallelArray<u32> node_remains(num_nodes, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            node_remains[u] = roots[u] == u;
+        }
+
+        ParallelArray<u32> node_remains_prefix(num_nodes, NUM_THREADS);
+        __gnu_parallel::partial_sum(node_remains.begin(), node_remains.end(), node_remains_prefix.begin());
+        ParallelArray<u32> new_nodes(node_remains_prefix[num_nodes - 1], NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 u = 0; u < num_nodes; ++u) {
+            if (node_remains[u]) {
+                new_nodes[node_remains_prefix[u] - 1] = u;
             }
+        }
+
+        contracted.nodes.swap(new_nodes);
+        contracted.edges.swap(new_edges);
+        contracted.sort_edges();
+
+        contract_until_single_node(contracted, node_sets, mst, current_mst_size, num_nodes, NUM_THREADS);
+
+        return mst;
+    }
+
+    /**
+     * Loads a graph from given path (same format as in load_graph) and calculates its MST
+     * 
+     * Loading is overlapped with the first round: thread 0 parses edges in chunks of
+     * LOAD_CHUNK_SIZE and publishes them, meanwhile the other threads fold published chunks
+     * into an atomic per-node minimum using CAS. Thread 0 joins them once the file is read
+     * 
+     * Shortest edges are compared by { weight, id }, where the two copies of an input edge
+     * get ids 2i and 2i + 1. This is a total order on input edges, so no cycles are formed.
+     * The contraction does not need sorted edges, so the full sort of the input is skipped
+     */
+    ParallelArray<Edge> calculate_mst_from_file(std::string filename, u32 NUM_THREADS = omp_get_max_threads()) {
+        std::cout << "Loading graph from path " << filename << "\n";
+        std::ifstream in(filename);
 
-            /* Adding edges to MST */
-            ParallelArray<u32> edge_selected_prefix(graph.num_edges(), NUM_THREADS);
-            __gnu_parallel::partial_sum(edge_selected.begin(), edge_selected.end(), edge_selected_prefix.begin());
+        u32 num_nodes;
+        u64 file_num_edges;
+
+        in >> num_nodes >> file_num_edges;
+
+        std::cout << num_nodes << " nodes and " << file_num_edges << " edges\n";
+
+        I num_edges = checked_num_edges<I>(file_num_edges);
+        Graph graph(num_nodes, num_edges * 2);
+        ShortestEdges shortest_edges(num_nodes, NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < num_nodes; ++i) {
+            graph.nodes[i] = i;
+            shortest_edges[i] = NO_EDGE;
+        }
 
-            #pragma omp parallel for num_threads(NUM_THREADS)
-            for (u32 i = 0; i < graph.num_edges(); ++i) {
-                if (edge_selected[i]) {
-                    mst[current_mst_size + edge_selected_prefix[i] - 1] = graph.edges[i];
+        u32 num_chunks = (num_edges + LOAD_CHUNK_SIZE - 1) / LOAD_CHUNK_SIZE;
+        atomic_u32 chunks_loaded(0);
+        atomic_u32 next_chunk(0);
+
+        #pragma omp parallel num_threads(NUM_THREADS)
+        {
+            if (omp_get_thread_num() == 0) {
+                for (u32 chunk = 0; chunk < num_chunks; ++chunk) {
+                    /* Bounds are clamped in u64, chunk ends may not fit into small id types */
+                    I chunk_begin = static_cast<u64>(chunk) * LOAD_CHUNK_SIZE;
+                    I chunk_end = std::min<u64>(num_edges, static_cast<u64>(chunk + 1) * LOAD_CHUNK_SIZE);
+
+                    for (I i = chunk_begin; i < chunk_end; ++i) {
+                        u32 from, to;
+                        W weight;
+                        in >> from >> to >> weight;
+                        graph.edges[2 * i] = Edge(from, to, weight);
+                        graph.edges[2 * i + 1] = Edge(to, from, weight);
+                    }
+
+                    chunks_loaded.store(chunk + 1, std::memory_order_release);
                 }
             }
-            current_mst_size += edge_selected_prefix[graph.num_edges() - 1];
 
-            /* Calculating remaining edges */
-            ParallelArray<u32> edge_remains(graph.num_edges(), NUM_THREADS);
-            #pragma omp parallel for
-            for (u32 i = 0; i < graph.num_edges(); ++i) {
-                edge_remains[i] = !node_sets.same_set(graph.edges[i].from, graph.edges[i].to);
-            }
+            while (true) {
+                u32 chunk = next_chunk++;
+                if (chunk >= num_chunks) break;
 
-            ParallelArray<u32> edge_remains_prefix(graph.num_edges(), NUM_THREADS);
-            __gnu_parallel::partial_sum(edge_remains.begin(), edge_remains.end(), edge_remains_prefix.begin());
-            ParallelArray<Edge> new_edges(edge_remains_prefix[graph.num_edges() - 1], NUM_THREADS);
-                
-            #pragma omp parallel for num_threads(NUM_THREADS)
-            for (u32 i = 0; i < graph.num_edges(); ++i) {
-                if (edge_remains[i]) {
-                    const Edge& old_edge = graph.edges[i];
-                    new_edges[edge_remains_prefix[i] - 1] = Edge(node_sets.find_root(old_edge.from),
-                                                                    node_sets.find_root(old_edge.to),
-                                                                    old_edge.weight);
+                while (chunks_loaded.load(std::memory_order_acquire) <= chunk) {
+                    std::this_thread::yield();
                 }
-            }
-                
-            /* Calculating remaining nodes */
-            ParallelArray<u32> node_remains(graph.num_nodes(), NUM_THREADS);
-            #pragma omp parallel for num_threads(NUM_THREADS)
-            for (u32 i = 0; i < graph.num_nodes(); ++i) {
-                node_remains[i] = (
-                    node_sets.find_root(graph.nodes[i]) == graph.nodes[i]
-                );
-            }
 
-            ParallelArray<u32> node_remains_prefix(graph.num_nodes(), NUM_THREADS);
-            __gnu_parallel::partial_sum(node_remains.begin(), node_remains.end(), node_remains_prefix.begin());
-            ParallelArray<u32> new_nodes(node_remains_prefix[graph.num_nodes() - 1]);
+                I chunk_begin = 2 * static_cast<u64>(chunk) * LOAD_CHUNK_SIZE;
+                I chunk_end = 2 * std::min<u64>(num_edges, static_cast<u64>(chunk + 1) * LOAD_CHUNK_SIZE);
 
-            #pragma omp parallel for num_threads(NUM_THREADS)
-            for (u32 i = 0; i < graph.num_nodes(); ++i) {
-                if (node_remains[i]) {
-                    new_nodes[node_remains_prefix[i] - 1] = graph.nodes[i];
+                for (I i = chunk_begin; i < chunk_end; ++i) {
+                    const Edge& e = graph.edges[i];
+                    EncodedEdge encoded_edge = encode_edge(i, e.weight);
+                    EncodedEdge old = shortest_edges[e.from];
+
+                    /* Atomic minimum, on failure old is reloaded by CAS */
+                    while (edge_less(encoded_edge, old, graph) &&
+                           !shortest_edges[e.from].compare_exchange_weak(old, encoded_edge)) {}
                 }
             }
+        }
+
+        std::cout << "Graph loaded\n";
+
+        ParallelDSU node_sets(num_nodes, NUM_THREADS);
+        ParallelArray<Edge> mst(num_nodes - 1, NUM_THREADS);
+        u32 current_mst_size = 0;
 
-            /* Swapping old graph for new graph */
-            graph.nodes.swap(new_nodes);
-            graph.edges.swap(new_edges);
-            graph.sort_edges();
+        if (num_nodes == 1) {
+            return mst;
         }
 
+        ContractedGraph contracted(0, 0);
+        contract(graph, contracted, shortest_edges, node_sets, mst, current_mst_size, NUM_THREADS);
+
+        /* The input is not needed anymore */
+        graph.nodes = ParallelArray<u32>(0);
+        graph.edges = ParallelArray<Edge, I>(0);
+
+        contract_until_single_node(contracted, node_sets, mst, current_mst_size, num_nodes, NUM_THREADS);
+
         return mst;
     }
 };
 
+using ParallelBoruvkaMST = BasicParallelBoruvkaMST<>;
+
 #endif
@@ -59,6 +59,10 @@ struct ParallelDSU {
         for (u32 i = 0; i < size; ++i) data[i] = i;
     }
 
+    /* data is owned by the DSU, copies would free it twice */
+    ParallelDSU(const ParallelDSU&) = delete;
+    ParallelDSU& operator=(const ParallelDSU&) = delete;
+
     u32 size() const {
         return dsu_size;
     }
@@ -180,6 +184,10 @@ struct ParallelDSU {
             break;
         }
     }
+
+    ~ParallelDSU() {
+        delete[] data;
+    }
 };
 
 #endif
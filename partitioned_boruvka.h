@@ -0,0 +1,226 @@
+#ifndef __PARTITIONED_BORUVKA_H
+#define __PARTITIONED_BORUVKA_H
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <omp.h>
+#include <parallel/algorithm>
+#include <parallel/numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "defs.h"
+#include "graph.h"
+#include "parallel_array.h"
+#include "parallel_dsu.h"
+#include "transport.h"
+
+/**
+ * Edge of the contracted graph which remembers the input edge it came from
+ * from and to are current component ids, original_from and original_to are input nodes
+ */
+struct PartitionedEdge {
+    u32 from;
+    u32 to;
+    u32 weight;
+    u32 original_from;
+    u32 original_to;
+
+    PartitionedEdge() {}
+
+    PartitionedEdge(const Edge& e) : from(e.from), to(e.to), weight(e.weight),
+                                     original_from(e.from), original_to(e.to) {}
+
+    /**
+     * Edges are compared by the canonical key of the input edge, so every rank breaks ties the same way
+     */
+    std::tuple<u32, u32, u32> key() const {
+        return canonical_key(original_from, original_to, weight);
+    }
+};
+
+/**
+ * MST of a graph split between processes of a group
+ *
+ * Nodes are split into size() contiguous ranges, a process owns the edges
+ * whose from lies in its range. Every round:
+ * 1. each process calculates the shortest edge of every component it owns
+ * 2. shortest edges are exchanged with all_gather, and every process applies
+ *    the same merges in the same order to its copy of the component DSU
+ * 3. each process relabels its edges, drops the ones inside a component and
+ *    sends every remaining edge to the owner of its new from with all_to_all
+ *
+ * Only the DSU (O(V)) is replicated, edges (O(E)) stay distributed.
+ * The algorithm stops when no process has edges left, so disconnected graphs
+ * produce a spanning forest. Every process returns the whole MST
+ */
+struct PartitionedBoruvkaMST {
+    u32 num_nodes;
+    u32 num_ranks;
+
+    PartitionedBoruvkaMST(u32 num_nodes, u32 num_ranks) : num_nodes(num_nodes), num_ranks(num_ranks) {
+        if (num_ranks == 0) {
+            throw std::invalid_argument("Number of ranks cannot be zero");
+        }
+    }
+
+    u32 block_size() const {
+        return (num_nodes + num_ranks - 1) / num_ranks;
+    }
+
+    u32 owner(u32 node) const {
+        return node / block_size();
+    }
+
+    u32 range_begin(u32 rank) const {
+        return std::min(num_nodes, rank * block_size());
+    }
+
+    u32 range_end(u32 rank) const {
+        return std::min(num_nodes, (rank + 1) * block_size());
+    }
+
+    /**
+     * Loads the part of a graph owned by rank from given path (same format as in load_graph)
+     * The whole file is streamed, but only edges going from the owned range are stored
+     */
+    Graph load_graph_partition(std::string filename, u32 rank) {
+        std::ifstream in(filename);
+
+        u32 file_num_nodes;
+        u32 file_num_edges;
+
+        in >> file_num_nodes >> file_num_edges;
+
+        if (file_num_nodes != num_nodes) {
+            throw std::invalid_argument("Graph has a different number of nodes");
+        }
+
+        u32 begin = range_begin(rank);
+        u32 end = range_end(rank);
+
+        std::vector<Edge> local_edges;
+        for (u32 i = 0; i < file_num_edges; ++i) {
+            u32 from, to, weight;
+            in >> from >> to >> weight;
+            if (begin <= from && from < end) local_edges.emplace_back(from, to, weight);
+            if (begin <= to && to < end) local_edges.emplace_back(to, from, weight);
+        }
+
+        Graph G(end - begin, local_edges.size());
+
+        #pragma omp parallel for
+        for (u32 i = 0; i < G.num_nodes(); ++i) {
+            G.nodes[i] = begin + i;
+        }
+
+        #pragma omp parallel for
+        for (u32 i = 0; i < G.num_edges(); ++i) {
+            G.edges[i] = local_edges[i];
+        }
+
+        G.sort_edges();
+
+        return G;
+    }
+
+    /**
+     * Calculates MST of the graph whose local part is local_graph
+     * Must be called by all ranks of the transport
+     */
+    ParallelArray<Edge> calculate_mst(Transport& transport, const Graph& local_graph,
+                                      u32 NUM_THREADS = omp_get_max_threads()) {
+        if (transport.size() != num_ranks) {
+            throw std::invalid_argument("Transport size does not match number of ranks");
+        }
+
+        std::vector<PartitionedEdge> edges(local_graph.num_edges());
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < local_graph.num_edges(); ++i) {
+            edges[i] = PartitionedEdge(local_graph.edges[i]);
+        }
+
+        ParallelDSU node_sets(num_nodes, NUM_THREADS);
+        std::vector<Edge> mst;
+
+        auto edge_less = [](const PartitionedEdge& a, const PartitionedEdge& b) {
+            return std::make_tuple(a.from, a.key()) < std::make_tuple(b.from, b.key());
+        };
+
+        while (true) {
+            /* Calculating shortest edges of local components, the first edge of each segment */
+            __gnu_parallel::sort(edges.begin(), edges.end(), edge_less);
+
+            std::vector<PartitionedEdge> shortest_edges;
+            for (u32 i = 0; i < edges.size(); ++i) {
+                if (i == 0 || edges[i].from != edges[i - 1].from) {
+                    shortest_edges.push_back(edges[i]);
+                }
+            }
+
+            /* Exchanging shortest edges */
+            std::vector<PartitionedEdge> all_shortest_edges;
+            for (const auto& message : all_gather(transport, pack_message(shortest_edges))) {
+                auto rank_edges = unpack_message<PartitionedEdge>(message);
+                all_shortest_edges.insert(all_shortest_edges.end(), rank_edges.begin(), rank_edges.end());
+            }
+
+            if (all_shortest_edges.empty()) break;
+
+            /* Every rank merges components in the same order, so component ids match everywhere */
+            std::sort(all_shortest_edges.begin(), all_shortest_edges.end(),
+                      [](const PartitionedEdge& a, const PartitionedEdge& b) {
+                          return std::make_tuple(a.key(), a.from) < std::make_tuple(b.key(), b.from);
+                      });
+
+            for (const auto& e : all_shortest_edges) {
+                if (!node_sets.same_set(e.from, e.to)) {
+                    node_sets.unite(e.from, e.to);
+                    mst.emplace_back(e.original_from, e.original_to, e.weight);
+                }
+            }
+
+            /* Relabeling remaining edges and sending them to their new owners */
+            ParallelArray<u32> edge_remains(edges.size(), NUM_THREADS);
+
+            #pragma omp parallel for num_threads(NUM_THREADS)
+            for (u32 i = 0; i < edges.size(); ++i) {
+                edges[i].from = node_sets.find_root(edges[i].from);
+                edges[i].to = node_sets.find_root(edges[i].to);
+                edge_remains[i] = edges[i].from != edges[i].to;
+            }
+
+            std::vector<std::vector<PartitionedEdge>> rank_edges(num_ranks);
+            for (u32 i = 0; i < edges.size(); ++i) {
+                if (edge_remains[i]) {
+                    rank_edges[owner(edges[i].from)].push_back(edges[i]);
+                }
+            }
+
+            std::vector<std::vector<char>> outgoing(num_ranks);
+            for (u32 rank = 0; rank < num_ranks; ++rank) {
+                outgoing[rank] = pack_message(rank_edges[rank]);
+            }
+
+            edges.clear();
+            for (const auto& message : all_to_all(transport, outgoing)) {
+                auto received = unpack_message<PartitionedEdge>(message);
+                edges.insert(edges.end(), received.begin(), received.end());
+            }
+        }
+
+        ParallelArray<Edge> result(mst.size(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < mst.size(); ++i) {
+            result[i] = mst[i];
+        }
+
+        return result;
+    }
+};
+
+#endif
@@ -2,13 +2,20 @@
 #define __SEQUENTIAL_MST_H
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "graph.h"
 #include "parallel_array.h"
 #include "sequential_dsu.h"
 
-struct SequentialBoruvkaMST {
+template<typename W = u32, typename I = u32>
+struct BasicSequentialBoruvkaMST {
+    using Edge = BasicEdge<W>;
+    using Graph = BasicGraph<W, I>;
+
+    const I NO_EDGE = std::numeric_limits<I>::max();
+
     ParallelArray<Edge> calculate_mst(Graph graph) {
         SequentialDSU node_sets(graph.num_nodes());
         ParallelArray<Edge> mst(graph.num_nodes() - 1);
@@ -16,13 +23,12 @@ struct SequentialBoruvkaMST {
         u32 initial_num_nodes = graph.num_nodes();
 
         while (graph.num_nodes() != 1) {
-            std::vector<std::pair<u32, u32>> shortest_edges(initial_num_nodes, 
-                                                           { 0, std::numeric_limits<u32>::max() });
+            std::vector<std::pair<I, W>> shortest_edges(initial_num_nodes, { NO_EDGE, W() });
 
-            for (u32 i = 0; i < graph.num_edges(); ++i) {
+            for (I i = 0; i < graph.num_edges(); ++i) {
                 const Edge& e = graph.edges[i];
 
-                if (shortest_edges[e.from].second > e.weight) {
+                if (shortest_edges[e.from].first == NO_EDGE || shortest_edges[e.from].second > e.weight) {
                     shortest_edges[e.from] = { i, e.weight };
                 }
             }
@@ -41,7 +47,7 @@ struct SequentialBoruvkaMST {
             }
 
             std::vector<Edge> new_edges;
-            for (u32 i = 0; i < graph.num_edges(); ++i) {
+            for (I i = 0; i < graph.num_edges(); ++i) {
                 if (!node_sets.same_set(graph.edges[i].from, graph.edges[i].to)) {
                     Edge e = graph.edges[i];
                     e.from = node_sets.find_root(e.from);
@@ -58,13 +64,13 @@ struct SequentialBoruvkaMST {
             }
 
             graph.nodes = ParallelArray<u32>(new_nodes.size());
-            graph.edges = ParallelArray<Edge>(new_edges.size());
+            graph.edges = ParallelArray<Edge, I>(new_edges.size());
 
             for (u32 i = 0; i < new_nodes.size(); ++i) {
                 graph.nodes[i] = new_nodes[i];
             }
 
-            for (u32 i = 0; i < new_edges.size(); ++i) {
+            for (I i = 0; i < new_edges.size(); ++i) {
                 graph.edges[i] = new_edges[i];
             }
         }
@@ -73,4 +79,6 @@ struct SequentialBoruvkaMST {
     }
 };
 
+using SequentialBoruvkaMST = BasicSequentialBoruvkaMST<>;
+
 #endif
@@ -9,7 +9,7 @@ struct SequentialDSU {
     u32* rank;
 
     SequentialDSU(u32 size) : size(size) {
-        rank = new u32[size];
+        rank = new u32[size]();
         parent = new u32[size];
         for (u32 i = 0; i < size; ++i) parent[i] = i;
     }
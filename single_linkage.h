@@ -0,0 +1,280 @@
+#ifndef __SINGLE_LINKAGE_H
+#define __SINGLE_LINKAGE_H
+
+#include <algorithm>
+#include <limits>
+#include <omp.h>
+#include <parallel/algorithm>
+#include <parallel/numeric>
+#include <vector>
+
+#include "defs.h"
+#include "graph.h"
+#include "parallel_array.h"
+#include "parallel_boruvka.h"
+#include "parallel_dsu.h"
+#include "sequential_dsu.h"
+
+/**
+ * A row of the dendrogram, same layout as a SciPy linkage matrix
+ * Clusters 0 .. N - 1 are the nodes, merge i creates cluster N + i
+ */
+struct DendrogramMerge {
+    u32 left;
+    u32 right;
+    u32 weight;
+    u32 size;
+};
+
+struct Clustering {
+    u32 num_clusters;
+    ParallelArray<u32> labels;
+    std::vector<DendrogramMerge> dendrogram;
+};
+
+/**
+ * Single-linkage clustering built on top of ParallelBoruvkaMST
+ *
+ * Clusters are the components of the MST without its heaviest edges,
+ * so there is no need to finish the MST: Boruvka rounds are run only
+ * while they do not go past the target, nodes get their labels from the DSU
+ *
+ * In threshold mode edges heavier than the threshold are dropped before the first round,
+ * then full rounds are run until no edges are left, they cannot go past a single cluster
+ *
+ * In count mode a round must not make more merges than there are left, so it only adds
+ * the shortest edges of the components which are among the max_merges smallest in { weight, id }
+ * order. Ids break ties, so a part of the edges with equal weights can be added and every round
+ * makes at least one merge (the smallest shortest edge is always added). Kruskal over the
+ * contracted graph is only left for the case when a round makes no merges
+ */
+struct SingleLinkageClustering {
+    using ContractedGraph = ParallelBoruvkaMST::ContractedGraph;
+
+    ParallelBoruvkaMST boruvka;
+
+    /**
+     * Splits nodes into num_clusters clusters
+     * If the graph has more components than that, every component is a cluster
+     */
+    Clustering cluster_by_count(const Graph& graph, u32 num_clusters, bool build_dendrogram = false,
+                                u32 NUM_THREADS = omp_get_max_threads()) {
+        if (num_clusters == 0) {
+            throw std::invalid_argument("Number of clusters cannot be zero");
+        }
+        return cluster(graph, num_clusters, std::numeric_limits<u32>::max(), build_dendrogram, NUM_THREADS);
+    }
+
+    /**
+     * Merges nodes connected by paths of edges not heavier than max_weight
+     */
+    Clustering cluster_by_threshold(const Graph& graph, u32 max_weight, bool build_dendrogram = false,
+                                    u32 NUM_THREADS = omp_get_max_threads()) {
+        return cluster(graph, 1, max_weight, build_dendrogram, NUM_THREADS);
+    }
+
+    Clustering cluster(const Graph& graph, u32 num_clusters, u32 max_weight, bool build_dendrogram,
+                       u32 NUM_THREADS) {
+        u32 num_nodes = graph.num_nodes();
+
+        if (num_nodes == 0) {
+            return Clustering{0, ParallelArray<u32>(0, NUM_THREADS), {}};
+        }
+
+        ParallelDSU node_sets(num_nodes, NUM_THREADS);
+        ParallelArray<Edge> merges(num_nodes - 1, NUM_THREADS);
+        u32 num_merges = 0;
+        u32 num_components = num_nodes;
+
+        /* The input is only read, the first round writes the contracted graph to working */
+        ContractedGraph working(0, 0);
+        bool on_input = true;
+        bool by_threshold = max_weight != std::numeric_limits<u32>::max();
+
+        if (by_threshold) {
+            filter_edges(graph, working, max_weight, NUM_THREADS);
+            on_input = false;
+        }
+
+        while (num_components > num_clusters) {
+            /* Threshold mode cannot overshoot a single cluster, so its rounds are not limited */
+            u32 max_merges = by_threshold ? num_nodes : num_components - num_clusters;
+            u32 round_merges = on_input ?
+                contract_round(graph, working, node_sets, merges, num_merges, max_merges, NUM_THREADS) :
+                contract_round(working, working, node_sets, merges, num_merges, max_merges, NUM_THREADS);
+
+            if (round_merges == 0) break;
+
+            on_input = false;
+            num_components -= round_merges;
+        }
+
+        if (num_components > num_clusters) {
+            if (on_input) {
+                merge_lightest(graph, node_sets, merges, num_merges, num_components - num_clusters, NUM_THREADS);
+            } else {
+                merge_lightest(working, node_sets, merges, num_merges, num_components - num_clusters, NUM_THREADS);
+            }
+        }
+
+        ConnectedComponents components = label_components(node_sets, NUM_THREADS);
+        Clustering result{components.num_components, std::move(components.labels), {}};
+
+        if (build_dendrogram) {
+            result.dendrogram = calculate_dendrogram(num_nodes, merges, num_merges);
+        }
+
+        return result;
+    }
+
+    /**
+     * Runs a single Boruvka round which makes at most max_merges merges and returns their number
+     * If it is zero, nothing is written to working
+     * G is Graph or ContractedGraph, current may be working itself
+     */
+    template<typename G>
+    u32 contract_round(const G& current, ContractedGraph& working, ParallelDSU& node_sets, ParallelArray<Edge>& merges,
+                       u32& num_merges, u32 max_merges, u32 NUM_THREADS) {
+        if (current.num_edges() == 0) return 0;
+
+        ParallelBoruvkaMST::ShortestEdges shortest_edges(node_sets.size(), NUM_THREADS);
+        boruvka.calculate_shortest_edges(current, shortest_edges, NUM_THREADS);
+
+        auto limit = shortest_edge_limit(current, shortest_edges, max_merges, NUM_THREADS);
+        u32 round_merges = 0;
+
+        #pragma omp parallel for reduction(+:round_merges) num_threads(NUM_THREADS)
+        for (u32 i = 0; i < current.num_nodes(); ++i) {
+            round_merges += boruvka.is_selected(current, shortest_edges, current.nodes[i], limit);
+        }
+
+        if (round_merges != 0) {
+            boruvka.contract(current, working, shortest_edges, node_sets, merges, num_merges, limit, NUM_THREADS);
+        }
+
+        return round_merges;
+    }
+
+    /**
+     * Kruskal over the edges of current, stops after max_merges merges
+     */
+    template<typename G>
+    void merge_lightest(const G& current, ParallelDSU& node_sets, ParallelArray<Edge>& merges, u32& num_merges,
+                        u32 max_merges, u32 NUM_THREADS) {
+        ParallelArray<Edge> edges(current.num_edges(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < current.num_edges(); ++i) {
+            edges[i] = boruvka.original_edge(current.edges[i]);
+        }
+
+        __gnu_parallel::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+            return std::tie(a.weight, a.from, a.to) < std::tie(b.weight, b.from, b.to);
+        });
+
+        for (u32 i = 0; i < edges.size() && max_merges != 0; ++i) {
+            if (!node_sets.same_set(edges[i].from, edges[i].to)) {
+                node_sets.unite(edges[i].from, edges[i].to);
+                merges[num_merges++] = edges[i];
+                --max_merges;
+            }
+        }
+    }
+
+    /**
+     * Returns the shortest edge such that exactly max_merges components have a smaller shortest edge
+     * in { weight, id } order, or NO_EDGE if all of them can be added
+     */
+    template<typename G>
+    ParallelBoruvkaMST::EncodedEdge shortest_edge_limit(const G& graph,
+                                                        ParallelBoruvkaMST::ShortestEdges& shortest_edges,
+                                                        u32 max_merges, u32 NUM_THREADS) {
+        if (max_merges >= graph.num_nodes()) {
+            return boruvka.NO_EDGE;
+        }
+
+        ParallelArray<ParallelBoruvkaMST::EncodedEdge> encoded_edges(graph.num_nodes(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_nodes(); ++i) {
+            encoded_edges[i] = shortest_edges[graph.nodes[i]];
+        }
+
+        __gnu_parallel::nth_element(encoded_edges.begin(), encoded_edges.begin() + max_merges, encoded_edges.end(),
+                                    [&](ParallelBoruvkaMST::EncodedEdge a, ParallelBoruvkaMST::EncodedEdge b) {
+                                        return boruvka.edge_less(a, b, graph);
+                                    });
+
+        return encoded_edges[max_merges];
+    }
+
+    /**
+     * Copies edges not heavier than max_weight to filtered, keeping their order
+     */
+    void filter_edges(const Graph& graph, ContractedGraph& filtered, u32 max_weight, u32 NUM_THREADS) {
+        ParallelArray<u32> edge_remains(graph.num_edges(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_edges(); ++i) {
+            edge_remains[i] = graph.edges[i].weight <= max_weight;
+        }
+
+        ParallelArray<u32> edge_remains_prefix(graph.num_edges(), NUM_THREADS);
+        __gnu_parallel::partial_sum(edge_remains.begin(), edge_remains.end(), edge_remains_prefix.begin());
+
+        u32 num_edges = graph.num_edges() == 0 ? 0 : edge_remains_prefix[graph.num_edges() - 1];
+        ParallelArray<ContractedEdge<u32>> new_edges(num_edges, NUM_THREADS);
+        ParallelArray<u32> new_nodes(graph.num_nodes(), NUM_THREADS);
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_edges(); ++i) {
+            if (edge_remains[i]) {
+                const Edge& e = graph.edges[i];
+                new_edges[edge_remains_prefix[i] - 1] = ContractedEdge<u32>(e.from, e.to, e.weight, e.from, e.to);
+            }
+        }
+
+        #pragma omp parallel for num_threads(NUM_THREADS)
+        for (u32 i = 0; i < graph.num_nodes(); ++i) {
+            new_nodes[i] = graph.nodes[i];
+        }
+
+        filtered.nodes.swap(new_nodes);
+        filtered.edges.swap(new_edges);
+    }
+
+    /**
+     * Replays merges in the order of their weights
+     * Merge edges may connect any nodes of the two clusters
+     */
+    std::vector<DendrogramMerge> calculate_dendrogram(u32 num_nodes, ParallelArray<Edge>& merges, u32 num_merges) {
+        __gnu_parallel::sort(merges.begin(), merges.begin() + num_merges, [](const Edge& a, const Edge& b) {
+            return std::tie(a.weight, a.from, a.to) < std::tie(b.weight, b.from, b.to);
+        });
+
+        SequentialDSU clusters(num_nodes);
+        std::vector<u32> cluster_id(num_nodes);
+        std::vector<u32> cluster_size(num_nodes, 1);
+        std::vector<DendrogramMerge> dendrogram(num_merges);
+
+        for (u32 i = 0; i < num_nodes; ++i) {
+            cluster_id[i] = i;
+        }
+
+        for (u32 i = 0; i < num_merges; ++i) {
+            u32 u = clusters.find_root(merges[i].from);
+            u32 v = clusters.find_root(merges[i].to);
+
+            dendrogram[i] = { cluster_id[u], cluster_id[v], merges[i].weight, cluster_size[u] + cluster_size[v] };
+
+            clusters.unite(u, v);
+            u32 root = clusters.find_root(u);
+            cluster_id[root] = num_nodes + i;
+            cluster_size[root] = dendrogram[i].size;
+        }
+
+        return dendrogram;
+    }
+};
+
+#endif
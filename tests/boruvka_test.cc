@@ -1,7 +1,45 @@
+#include "../batch_boruvka.h"
 #include "../benchmark.h"
+#include "../compressed_graph.h"
+#include "../deterministic_boruvka.h"
 #include "../parallel_boruvka.h"
 #include "../graph.h"
+#include "../mst_cache.h"
+#include "../mst_verifier.h"
 #include "../sequential_boruvka.h"
+#include "../single_linkage.h"
+
+static_assert(std::is_same<EdgeEncoding<u16, u16>::Storage, u32>::value, "u16 weights and ids are packed into u32");
+static_assert(std::is_same<EdgeEncoding<float, u32>::Storage, u64>::value, "float weights are packed into u64");
+static_assert(std::is_base_of<IndirectEdgeEncoding<double, u64>, EdgeEncoding<double, u64>>::value,
+              "double weights with u64 ids are indirect");
+
+/**
+ * Loads the graph with W weights and I ids and compares MST weights of both engines,
+ * the parallel one is run on the loaded graph and on the file (pipelined)
+ * Weights are compared as sorted lists, because floating point sums depend on the order
+ */
+template<typename W, typename I>
+bool check_weight_type(const char* filename) {
+    auto G = load_graph<W, I>(filename);
+
+    auto mst = BasicParallelBoruvkaMST<W, I>().calculate_mst(G);
+    auto pipelined_mst = BasicParallelBoruvkaMST<W, I>().calculate_mst_from_file(filename);
+    auto correct_mst = BasicSequentialBoruvkaMST<W, I>().calculate_mst(G);
+
+    std::vector<W> weights;
+    std::vector<W> pipelined_weights;
+    std::vector<W> correct_weights;
+    for (u32 i = 0; i < mst.size(); ++i) weights.push_back(mst[i].weight);
+    for (u32 i = 0; i < pipelined_mst.size(); ++i) pipelined_weights.push_back(pipelined_mst[i].weight);
+    for (u32 i = 0; i < correct_mst.size(); ++i) correct_weights.push_back(correct_mst[i].weight);
+
+    std::sort(weights.begin(), weights.end());
+    std::sort(pipelined_weights.begin(), pipelined_weights.end());
+    std::sort(correct_weights.begin(), correct_weights.end());
+
+    return weights == correct_weights && pipelined_weights == correct_weights;
+}
 
 int main(int argc, char* argv[]) {
     if (argc == 1) {
@@ -14,7 +52,51 @@ int main(int argc, char* argv[]) {
 
     Graph G = load_graph(argv[1]);
 
+    if (!is_connected(G)) {
+        std::cerr << "Graph is not connected\n";
+        exit(-1);
+    }
+
+    /* Components { 0, 1, 2 }, { 3, 4 }, { 5 } and { 6 }, and a long path which is a single component */
+    {
+        Graph components_graph(7, 6);
+        for (u32 i = 0; i < 7; ++i) components_graph.nodes[i] = i;
+        components_graph.edges[0] = Edge(0, 1, 1);
+        components_graph.edges[1] = Edge(1, 0, 1);
+        components_graph.edges[2] = Edge(1, 2, 1);
+        components_graph.edges[3] = Edge(2, 1, 1);
+        components_graph.edges[4] = Edge(3, 4, 1);
+        components_graph.edges[5] = Edge(4, 3, 1);
+        components_graph.sort_edges();
+
+        auto components = connected_components(components_graph);
+        std::vector<u32> component_of = { 0, 0, 0, 1, 1, 2, 3 };
+
+        bool labels_correct = true;
+        for (u32 u = 0; u < 7; ++u) {
+            for (u32 v = 0; v < 7; ++v) {
+                labels_correct &= (components.labels[u] == components.labels[v]) == (component_of[u] == component_of[v]);
+            }
+        }
+
+        u32 path_length = 1000000;
+        Graph path(path_length, 2 * (path_length - 1));
+        for (u32 i = 0; i < path_length; ++i) path.nodes[i] = i;
+        for (u32 i = 0; i + 1 < path_length; ++i) {
+            path.edges[2 * i] = Edge(i, i + 1, 1);
+            path.edges[2 * i + 1] = Edge(i + 1, i, 1);
+        }
+        path.sort_edges();
+
+        if (components.num_components != 4 || !labels_correct || !is_connected(path)) {
+            std::cerr << "Wrong connected components!\n";
+            exit(-1);
+        }
+    }
+
     u64 weight_to_check = 0;
+    u64 weight_pipelined = 0;
+    u64 weight_compressed = 0;
     u64 weight_correct = 0;
     
     {
@@ -22,6 +104,17 @@ int main(int argc, char* argv[]) {
         for (u32 i = 0; i < mst.size(); ++i) weight_to_check += mst[i].weight;
     }
     
+    {
+        auto mst = boruvka.calculate_mst_from_file(argv[1]);
+        for (u32 i = 0; i < mst.size(); ++i) weight_pipelined += mst[i].weight;
+    }
+    
+    {
+        CompressedGraph compressed(G);
+        auto mst = boruvka.calculate_mst(compressed);
+        for (u32 i = 0; i < mst.size(); ++i) weight_compressed += mst[i].weight;
+    }
+
     {
         auto mst = sequential_mst.calculate_mst(G);
         for (u32 i = 0; i < mst.size(); ++i) weight_correct += mst[i].weight;
@@ -31,8 +124,288 @@ int main(int argc, char* argv[]) {
         std::cerr << "Weights don't match!\nCorrect: " << weight_correct << "\nIncorrect: " << weight_to_check << "\n";
         exit(-1);
     }
-    else {
-        std::cout << "OK\n";
+    else if (weight_pipelined != weight_correct) {
+        std::cerr << "Pipelined weights don't match!\nCorrect: " << weight_correct << "\nIncorrect: " << weight_pipelined << "\n";
+        exit(-1);
+    }
+    else if (weight_compressed != weight_correct) {
+        std::cerr << "Compressed weights don't match!\nCorrect: " << weight_correct << "\nIncorrect: " << weight_compressed << "\n";
+        exit(-1);
+    }
+
+    /*
+     * Verifier accepts the MST, rejects a spanning tree where a tree edge is swapped
+     * for a heavier edge crossing the same cut, and a candidate with a repeated edge
+     */
+    {
+        MSTVerifier verifier;
+        auto mst = boruvka.calculate_mst(G);
+
+        if (!verifier.verify(G, mst).is_mst()) {
+            std::cerr << "Verifier rejected the MST!\n";
+            exit(-1);
+        }
+
+        std::vector<std::vector<std::pair<u32, u32>>> tree(G.num_nodes());
+        for (u32 i = 0; i < mst.size(); ++i) {
+            tree[mst[i].from].push_back({ mst[i].to, i });
+            tree[mst[i].to].push_back({ mst[i].from, i });
+        }
+
+        bool swapped = false;
+        for (u32 i = 0; i < G.num_edges() && i < 1000 && !swapped; ++i) {
+            const Edge& e = G.edges[i];
+
+            /* Tree path from e.to to e.from, parent_edge[v] is the tree edge towards e.from */
+            std::vector<u32> parent_edge(G.num_nodes(), G.num_nodes());
+            std::vector<u32> queue = { e.from };
+            parent_edge[e.from] = mst.size();
+            for (u32 j = 0; j < queue.size(); ++j) {
+                for (auto [v, id] : tree[queue[j]]) {
+                    if (parent_edge[v] == G.num_nodes()) {
+                        parent_edge[v] = id;
+                        queue.push_back(v);
+                    }
+                }
+            }
+
+            /* Removing any edge of the path and adding e gives a spanning tree again */
+            u32 lightest = mst.size();
+            for (u32 v = e.to; v != e.from;) {
+                u32 id = parent_edge[v];
+                if (lightest == mst.size() || mst[id].weight < mst[lightest].weight) lightest = id;
+                v = mst[id].from == v ? mst[id].to : mst[id].from;
+            }
+
+            if (lightest != mst.size() && mst[lightest].weight < e.weight) {
+                auto candidate = mst;
+                candidate[lightest] = e;
+
+                auto verification = verifier.verify(G, candidate);
+                if (!verification.is_spanning_tree || verification.is_mst()) {
+                    std::cerr << "Verifier accepted a spanning tree with an F-light edge!\n";
+                    exit(-1);
+                }
+                swapped = true;
+            }
+        }
+
+        if (mst.size() >= 2) {
+            mst[0] = mst[1];
+            if (verifier.verify(G, mst).is_spanning_tree) {
+                std::cerr << "Verifier accepted a candidate with a cycle!\n";
+                exit(-1);
+            }
+        }
+    }
+
+    /* Deterministic MST is the same for any number of threads, cache returns it again */
+    {
+        DeterministicBoruvkaMST deterministic_mst;
+        auto mst = deterministic_mst.calculate_mst(G, 1);
+        auto other_mst = deterministic_mst.calculate_mst(G, 4);
+
+        u64 weight = 0;
+        bool same = mst.size() == other_mst.size();
+        for (u32 i = 0; i < mst.size(); ++i) {
+            weight += mst[i].weight;
+            same &= mst[i].from == other_mst[i].from && mst[i].to == other_mst[i].to &&
+                    mst[i].weight == other_mst[i].weight;
+        }
+
+        if (!same || weight != weight_correct || !MSTVerifier().verify(G, mst).is_mst()) {
+            std::cerr << "Deterministic MST is wrong or depends on the number of threads!\n";
+            exit(-1);
+        }
+
+        auto directory = std::filesystem::temp_directory_path() / ("boruvka_test_cache_" + std::to_string(getpid()));
+        std::filesystem::remove_all(directory);
+
+        MSTCache cache(directory.string());
+        cache.calculate_mst(G);
+        auto cached_mst = cache.calculate_mst(G);
+
+        for (u32 i = 0; i < mst.size(); ++i) {
+            same &= mst[i].from == cached_mst[i].from && mst[i].to == cached_mst[i].to &&
+                    mst[i].weight == cached_mst[i].weight;
+        }
+
+        /* Spanning forests are cached too, a file with edges missing from the graph is a miss */
+        Graph forest(5, 4);
+        for (u32 i = 0; i < 5; ++i) forest.nodes[i] = i;
+        forest.edges[0] = Edge(0, 1, 7);
+        forest.edges[1] = Edge(1, 0, 7);
+        forest.edges[2] = Edge(2, 3, 5);
+        forest.edges[3] = Edge(3, 2, 5);
+        forest.sort_edges();
+
+        cache.calculate_mst(forest);
+        same &= cache.calculate_mst(forest).size() == 2;
+
+        ParallelArray<Edge> wrong_mst(2);
+        wrong_mst[0] = Edge(0, 4, 5);
+        wrong_mst[1] = Edge(1, 2, 7);
+        cache.store(cache.file_path(cache.hash_graph(forest)), forest, wrong_mst);
+        auto forest_mst = cache.calculate_mst(forest);
+        same &= forest_mst.size() == 2 && forest_mst[0].from == 2 && forest_mst[1].from == 0;
+
+        std::filesystem::remove_all(directory);
+
+        if (cache.num_hits != 2 || cache.num_misses != 3 || !same) {
+            std::cerr << "Cached MST doesn't match!\n";
+            exit(-1);
+        }
+    }
+
+    if (!check_weight_type<int, u32>(argv[1]) || !check_weight_type<float, u32>(argv[1]) ||
+        !check_weight_type<double, u64>(argv[1]) || !check_weight_type<u64, u64>(argv[1])) {
+        std::cerr << "Weights don't match for templated engines!\n";
+        exit(-1);
+    }
+
+    /* u16 ids only fit small graphs, a file with too many edges for them is rejected */
+    {
+        auto path = std::filesystem::temp_directory_path() / ("boruvka_test_u16_" + std::to_string(getpid()));
+        Graph small = generate_graph(1000, 3000);
+
+        {
+            std::ofstream out(path);
+            out << small.num_nodes() << " " << small.num_edges() / 2 << "\n";
+            for (u32 i = 0; i < small.num_edges(); ++i) {
+                const Edge& e = small.edges[i];
+                if (e.from < e.to) {
+                    out << e.from << " " << e.to << " " << e.weight % 60000 << "\n";
+                }
+            }
+        }
+
+        bool same = check_weight_type<u16, u16>(path.c_str());
+
+        {
+            std::ofstream out(path);
+            out << "3 40000\n";
+        }
+
+        bool rejected = false;
+        try {
+            load_graph<u32, u16>(path);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+
+        std::filesystem::remove(path);
+
+        if (!same || !rejected) {
+            std::cerr << "Wrong MST with u16 weights and ids or too many edges accepted!\n";
+            exit(-1);
+        }
     }
+
+    /* Single-linkage clustering, compared to the lightest edges of the sequential MST */
+    {
+        auto mst = sequential_mst.calculate_mst(G);
+        std::sort(mst.begin(), mst.end(), [](const Edge& a, const Edge& b) { return a.weight < b.weight; });
+
+        SingleLinkageClustering clustering;
+        u32 num_clusters = std::min<u32>(10, G.num_nodes());
+        auto clusters = clustering.cluster_by_count(G, num_clusters, true);
+
+        u64 dendrogram_weight = 0;
+        u64 dendrogram_weight_correct = 0;
+        for (const auto& merge : clusters.dendrogram) dendrogram_weight += merge.weight;
+        for (u32 i = 0; i < G.num_nodes() - num_clusters; ++i) dendrogram_weight_correct += mst[i].weight;
+
+        if (clusters.num_clusters != num_clusters || dendrogram_weight != dendrogram_weight_correct) {
+            std::cerr << "Wrong clustering by count!\nClusters: " << clusters.num_clusters
+                      << "\nCorrect weight: " << dendrogram_weight_correct << "\nIncorrect: " << dendrogram_weight << "\n";
+            exit(-1);
+        }
+
+        u32 max_weight = mst[mst.size() / 2].weight;
+        u32 num_clusters_correct = G.num_nodes();
+        for (u32 i = 0; i < mst.size(); ++i) num_clusters_correct -= mst[i].weight <= max_weight;
+
+        if (clustering.cluster_by_threshold(G, max_weight).num_clusters != num_clusters_correct) {
+            std::cerr << "Wrong clustering by threshold!\n";
+            exit(-1);
+        }
+
+        /* All weights are equal, so every round is a single tie */
+        Graph uniform(G.num_nodes(), G.num_edges());
+        for (u32 i = 0; i < G.num_nodes(); ++i) uniform.nodes[i] = G.nodes[i];
+        for (u32 i = 0; i < G.num_edges(); ++i) uniform.edges[i] = Edge(G.edges[i].from, G.edges[i].to, 1);
+
+        auto uniform_clusters = clustering.cluster_by_count(uniform, num_clusters, true);
+
+        if (uniform_clusters.num_clusters != num_clusters ||
+            uniform_clusters.dendrogram.size() != G.num_nodes() - num_clusters ||
+            clustering.cluster_by_threshold(uniform, 1).num_clusters != 1 ||
+            clustering.cluster_by_threshold(uniform, 0).num_clusters != G.num_nodes()) {
+            std::cerr << "Wrong clustering with equal weights!\n";
+            exit(-1);
+        }
+    }
+
+    /*
+     * Batch of small random graphs and a graph above SMALL_GRAPH_EDGES, which goes to ParallelBoruvkaMST
+     * Not connected graphs of both sizes get spanning forests
+     */
+    std::vector<Graph> graphs;
+    std::vector<u64> batch_weights_correct;
+    std::vector<u32> batch_sizes_correct;
+
+    for (u32 i = 2; i <= 100; ++i) {
+        graphs.push_back(generate_graph(i, 3 * i));
+    }
+    graphs.push_back(generate_graph(30000, 40000));
+
+    for (Graph& graph : graphs) {
+        u64 weight = 0;
+        auto mst = sequential_mst.calculate_mst(graph);
+        for (u32 j = 0; j < mst.size(); ++j) weight += mst[j].weight;
+        batch_weights_correct.push_back(weight);
+        batch_sizes_correct.push_back(mst.size());
+    }
+
+    /* Edges 0 - 1 and 2 - 3, node 4 is isolated */
+    Graph forest(5, 4);
+    for (u32 i = 0; i < 5; ++i) forest.nodes[i] = i;
+    forest.edges[0] = Edge(0, 1, 7);
+    forest.edges[1] = Edge(1, 0, 7);
+    forest.edges[2] = Edge(2, 3, 5);
+    forest.edges[3] = Edge(3, 2, 5);
+    forest.sort_edges();
+    graphs.push_back(std::move(forest));
+    batch_weights_correct.push_back(12);
+    batch_sizes_correct.push_back(2);
+
+    /* The large graph with an isolated node added */
+    const Graph& large = graphs[graphs.size() - 2];
+    Graph large_forest(large.num_nodes() + 1, large.num_edges());
+    for (u32 i = 0; i <= large.num_nodes(); ++i) large_forest.nodes[i] = i;
+    for (u32 i = 0; i < large.num_edges(); ++i) large_forest.edges[i] = large.edges[i];
+    batch_weights_correct.push_back(batch_weights_correct[graphs.size() - 2]);
+    batch_sizes_correct.push_back(batch_sizes_correct[graphs.size() - 2]);
+    graphs.push_back(std::move(large_forest));
+
+    BatchBoruvkaMST batch;
+    auto batch_result = batch.calculate_msts(graphs);
+
+    if (graphs[graphs.size() - 3].num_edges() < batch.SMALL_GRAPH_EDGES || !(batch_result.graphs_per_second > 0)) {
+        std::cerr << "Batch did not use the large graph path or has no throughput!\n";
+        exit(-1);
+    }
+
+    for (u32 i = 0; i < batch_result.msts.size(); ++i) {
+        u64 weight = 0;
+        for (u32 j = 0; j < batch_result.msts[i].size(); ++j) weight += batch_result.msts[i][j].weight;
+
+        if (weight != batch_weights_correct[i] || batch_result.msts[i].size() != batch_sizes_correct[i]) {
+            std::cerr << "Batch MST doesn't match for graph " << i << "!\nCorrect: " << batch_weights_correct[i] << "\nIncorrect: " << weight << "\n";
+            exit(-1);
+        }
+    }
+
+    std::cout << "OK\n";
     return 0;
 }
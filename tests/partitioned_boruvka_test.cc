@@ -0,0 +1,65 @@
+#include <stdlib.h>
+
+#include "../graph.h"
+#include "../partitioned_boruvka.h"
+#include "../sequential_boruvka.h"
+#include "../transport.h"
+
+const u32 NUM_RANKS = 4;
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        std::cerr << "Please specify path to graph\n";
+        exit(-1);
+    }
+
+    auto transport = launch_local_process_group(NUM_RANKS, argv);
+    u32 rank = transport->rank();
+
+    u32 num_nodes;
+    {
+        std::ifstream in(argv[1]);
+        in >> num_nodes;
+    }
+
+    PartitionedBoruvkaMST partitioned_mst(num_nodes, NUM_RANKS);
+    Graph local_graph = partitioned_mst.load_graph_partition(argv[1], rank);
+
+    u32 num_threads = std::max(1, omp_get_max_threads() / static_cast<int>(NUM_RANKS));
+    auto mst = partitioned_mst.calculate_mst(*transport, local_graph, num_threads);
+
+    if (rank != 0) {
+        return 0;
+    }
+
+    if (!transport->finish()) {
+        std::cerr << "One of the ranks failed\n";
+        exit(-1);
+    }
+
+    SequentialBoruvkaMST sequential_mst;
+    Graph G = load_graph(argv[1]);
+
+    u64 weight_to_check = 0;
+    u64 weight_correct = 0;
+
+    for (u32 i = 0; i < mst.size(); ++i) weight_to_check += mst[i].weight;
+
+    {
+        auto correct_mst = sequential_mst.calculate_mst(G);
+        for (u32 i = 0; i < correct_mst.size(); ++i) weight_correct += correct_mst[i].weight;
+    }
+
+    if (mst.size() != G.num_nodes() - 1) {
+        std::cerr << "Wrong number of edges in MST: " << mst.size() << "\n";
+        exit(-1);
+    }
+    else if (weight_to_check != weight_correct) {
+        std::cerr << "Weights don't match!\nCorrect: " << weight_correct << "\nIncorrect: " << weight_to_check << "\n";
+        exit(-1);
+    }
+    else {
+        std::cout << "OK\n";
+    }
+    return 0;
+}
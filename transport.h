@@ -0,0 +1,325 @@
+#ifndef __TRANSPORT_H
+#define __TRANSPORT_H
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#include "defs.h"
+
+/**
+ * INTERFACE:
+ *
+ * Transport - point to point channel between processes (ranks) of a group
+ * u32 rank() - rank of the current process
+ * u32 size() - number of processes in the group
+ * void send(u32 to, const std::vector<char>& message) - sends a message to rank to
+ * std::vector<char> recv(u32 from) - receives the next message sent by rank from
+ *
+ * Messages between a pair of ranks arrive in the order they were sent
+ *
+ * all_to_all() and all_gather() are built on top of send() and recv(),
+ * so a new backend (MPI, shared memory, TCP) only has to implement these four methods
+ */
+struct Transport {
+    virtual u32 rank() const = 0;
+    virtual u32 size() const = 0;
+    virtual void send(u32 to, const std::vector<char>& message) = 0;
+    virtual std::vector<char> recv(u32 from) = 0;
+
+    virtual ~Transport() {}
+};
+
+template<typename T>
+std::vector<char> pack_message(const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be sent");
+
+    std::vector<char> message(values.size() * sizeof(T));
+    if (!values.empty()) {
+        std::memcpy(message.data(), values.data(), message.size());
+    }
+    return message;
+}
+
+template<typename T>
+std::vector<T> unpack_message(const std::vector<char>& message) {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be received");
+
+    if (message.size() % sizeof(T) != 0) {
+        throw std::runtime_error("Message size does not match value type");
+    }
+
+    std::vector<T> values(message.size() / sizeof(T));
+    if (!values.empty()) {
+        std::memcpy(values.data(), message.data(), message.size());
+    }
+    return values;
+}
+
+/**
+ * Sends outgoing[r] to every rank r and returns messages received from every rank
+ *
+ * Sends are done from a separate thread while the current one receives.
+ * Both go through the ranks in increasing order, which can not deadlock
+ * even if the backend blocks on large messages
+ */
+std::vector<std::vector<char>> all_to_all(Transport& transport, std::vector<std::vector<char>>& outgoing) {
+    u32 rank = transport.rank();
+    u32 size = transport.size();
+
+    if (outgoing.size() != size) {
+        throw std::invalid_argument("Expected one outgoing message per rank");
+    }
+
+    std::vector<std::vector<char>> incoming(size);
+    incoming[rank].swap(outgoing[rank]);
+
+    std::exception_ptr send_error;
+    std::thread sender([&]() {
+        try {
+            for (u32 to = 0; to < size; ++to) {
+                if (to != rank) transport.send(to, outgoing[to]);
+            }
+        } catch (...) {
+            send_error = std::current_exception();
+        }
+    });
+
+    std::exception_ptr recv_error;
+    try {
+        for (u32 from = 0; from < size; ++from) {
+            if (from != rank) incoming[from] = transport.recv(from);
+        }
+    } catch (...) {
+        recv_error = std::current_exception();
+    }
+
+    sender.join();
+
+    if (send_error) std::rethrow_exception(send_error);
+    if (recv_error) std::rethrow_exception(recv_error);
+
+    return incoming;
+}
+
+/**
+ * Sends message to every rank and returns messages of all ranks ordered by rank
+ */
+std::vector<std::vector<char>> all_gather(Transport& transport, const std::vector<char>& message) {
+    std::vector<std::vector<char>> outgoing(transport.size(), message);
+    return all_to_all(transport, outgoing);
+}
+
+/**
+ * Transport over connected Unix sockets, one socket per pair of ranks
+ * Used to run a process group on a single machine
+ *
+ * Each message is sent as its size (u64) followed by its contents
+ */
+struct SocketTransport : Transport {
+    u32 transport_rank;
+    std::vector<int> peers;
+    std::vector<pid_t> children;
+
+    SocketTransport(u32 transport_rank, std::vector<int> peers) : transport_rank(transport_rank),
+                                                                 peers(std::move(peers)) {
+        if (transport_rank >= this->peers.size()) {
+            throw std::out_of_range("Rank out of range");
+        }
+    }
+
+    SocketTransport(const SocketTransport&) = delete;
+    SocketTransport& operator=(const SocketTransport&) = delete;
+
+    u32 rank() const override {
+        return transport_rank;
+    }
+
+    u32 size() const override {
+        return peers.size();
+    }
+
+    int peer_socket(u32 peer) const {
+        if (peer >= size() || peer == transport_rank) {
+            throw std::out_of_range("Peer rank out of range");
+        }
+        return peers[peer];
+    }
+
+    void send(u32 to, const std::vector<char>& message) override {
+        int fd = peer_socket(to);
+        u64 message_size = message.size();
+
+        write_all(fd, reinterpret_cast<const char*>(&message_size), sizeof(message_size));
+        write_all(fd, message.data(), message_size);
+    }
+
+    std::vector<char> recv(u32 from) override {
+        int fd = peer_socket(from);
+        u64 message_size;
+
+        read_all(fd, reinterpret_cast<char*>(&message_size), sizeof(message_size));
+        std::vector<char> message(message_size);
+        read_all(fd, message.data(), message_size);
+
+        return message;
+    }
+
+    static void write_all(int fd, const char* data, u64 length) {
+        while (length > 0) {
+            ssize_t written = ::send(fd, data, length, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("Socket send failed: ") + std::strerror(errno));
+            }
+            data += written;
+            length -= written;
+        }
+    }
+
+    static void read_all(int fd, char* data, u64 length) {
+        while (length > 0) {
+            ssize_t received = ::recv(fd, data, length, 0);
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("Socket recv failed: ") + std::strerror(errno));
+            }
+            if (received == 0) {
+                throw std::runtime_error("Peer closed the connection");
+            }
+            data += received;
+            length -= received;
+        }
+    }
+
+    /**
+     * Closes all sockets and waits for spawned ranks to finish,
+     * returns false if any of them exited with an error
+     */
+    bool finish() {
+        for (int& fd : peers) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+
+        bool success = true;
+        for (pid_t child : children) {
+            int status;
+            if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                success = false;
+            }
+        }
+        children.clear();
+
+        return success;
+    }
+
+    ~SocketTransport() {
+        finish();
+    }
+};
+
+const char* const LOCAL_GROUP_RANK_ENV = "BORUVKA_RANK";
+const char* const LOCAL_GROUP_PEERS_ENV = "BORUVKA_PEERS";
+
+/**
+ * Starts a group of num_ranks processes on the local machine, SPMD style
+ *
+ * Rank 0 is the calling process. It re-executes the current binary with the same
+ * arguments num_ranks - 1 times, passing each child its rank and sockets through
+ * the environment. When a child reaches this call it just picks them up,
+ * so every rank returns from here with its own transport
+ *
+ * Children are started with exec rather than a plain fork,
+ * because the OpenMP runtime does not survive fork in a process that already used it
+ */
+std::unique_ptr<SocketTransport> launch_local_process_group(u32 num_ranks, char* argv[]) {
+    const char* rank_env = std::getenv(LOCAL_GROUP_RANK_ENV);
+    const char* peers_env = std::getenv(LOCAL_GROUP_PEERS_ENV);
+
+    if (rank_env != nullptr && peers_env != nullptr) {
+        std::vector<int> peers;
+        std::string peers_list(peers_env);
+        size_t start = 0;
+
+        while (start <= peers_list.size()) {
+            size_t end = peers_list.find(',', start);
+            if (end == std::string::npos) end = peers_list.size();
+            peers.push_back(std::stoi(peers_list.substr(start, end - start)));
+            start = end + 1;
+        }
+
+        return std::make_unique<SocketTransport>(std::stoul(rank_env), peers);
+    }
+
+    if (num_ranks == 0) {
+        throw std::invalid_argument("Process group can not be empty");
+    }
+
+    /* sockets[i][j] is the end of the (i, j) connection owned by rank i */
+    std::vector<std::vector<int>> sockets(num_ranks, std::vector<int>(num_ranks, -1));
+    for (u32 i = 0; i < num_ranks; ++i) {
+        for (u32 j = i + 1; j < num_ranks; ++j) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
+                throw std::runtime_error(std::string("socketpair failed: ") + std::strerror(errno));
+            }
+            sockets[i][j] = pair[0];
+            sockets[j][i] = pair[1];
+        }
+    }
+
+    std::vector<pid_t> children;
+    for (u32 child_rank = 1; child_rank < num_ranks; ++child_rank) {
+        std::string peers_list;
+        for (u32 peer = 0; peer < num_ranks; ++peer) {
+            if (peer != 0) peers_list += ",";
+            peers_list += std::to_string(sockets[child_rank][peer]);
+        }
+        std::string rank_value = std::to_string(child_rank);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+        }
+
+        if (pid == 0) {
+            for (u32 i = 0; i < num_ranks; ++i) {
+                for (u32 j = 0; j < num_ranks; ++j) {
+                    if (i != child_rank && sockets[i][j] >= 0) ::close(sockets[i][j]);
+                }
+            }
+
+            setenv(LOCAL_GROUP_RANK_ENV, rank_value.c_str(), 1);
+            setenv(LOCAL_GROUP_PEERS_ENV, peers_list.c_str(), 1);
+            execv("/proc/self/exe", argv);
+            _exit(127);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (u32 i = 1; i < num_ranks; ++i) {
+        for (u32 j = 0; j < num_ranks; ++j) {
+            if (sockets[i][j] >= 0) ::close(sockets[i][j]);
+        }
+    }
+
+    auto transport = std::make_unique<SocketTransport>(0, sockets[0]);
+    transport->children = children;
+
+    return transport;
+}
+
+#endif